@@ -0,0 +1,12 @@
+# Plans many cases without the viewers (see main.cpp for the case files).
+
+TEMPLATE = app
+TARGET   = batch
+
+QT = core
+CONFIG += console warn_on thread c++14
+CONFIG -= app_bundle
+
+SOURCES  = main.cpp
+
+include( ../core/core.pri )
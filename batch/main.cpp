@@ -0,0 +1,306 @@
+#include "caseplanner.h"
+#include "meshreader.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+/*
+ * Plans a list of cases without the viewers. Each case is a JSON file :
+ *
+ *  { "mandible": { "mesh file": ..., "control points": [[x,y,z], ...] },
+ *    "fibula":   { "mesh file": ..., "control points": [[x,y,z], ...] },
+ *    "plan":     { "pieces": 3, "optimise": false } }
+ *
+ * "mandible" and "fibula" are read like MainWindow::readJSON. The cut mandible, the fibula segments (placed in the mandible)
+ * and metrics.csv are written to the output directory.
+*/
+
+// Only lets a case load its meshes once there's enough memory left for it (a case bigger than the whole budget runs on its own)
+class MemoryBudget
+{
+public:
+    MemoryBudget(unsigned long long bytes) : available(bytes), total(bytes){}
+
+    void acquire(unsigned long long bytes){
+        std::unique_lock<std::mutex> lock(mutex);
+        freed.wait(lock, [&](){ return bytes <= available || available == total; });
+        available -= std::min(bytes, available);
+    }
+
+    void release(unsigned long long bytes){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            available = std::min(total, available + std::min(bytes, total));
+        }
+        freed.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable freed;
+    unsigned long long available;
+    const unsigned long long total;
+};
+
+struct CaseResult{
+    QString name;
+    bool isPlanned = false;
+    QString error;
+    PieceCountEvaluator::PlanSummary summary;
+    unsigned int nbSegments = 0;
+    double duration = 0;        // ms, loading and writing included
+    unsigned long long estimatedBytes = 0;      // what the memory budget held back for the case
+    MemoryReport memory;        // the meshes and curves once planned
+};
+
+static std::mutex printMutex;
+
+static void print(const QString &message){
+    std::lock_guard<std::mutex> lock(printMutex);
+    std::cout << message.toStdString() << std::endl;
+}
+
+// What a mesh will need once it's loaded and cut (verticies, normals, smoothed verticies, flooding and one rings, triangles and the cut lists)
+static const unsigned long long bytesPerVertex = 160;
+static const unsigned long long bytesPerTriangle = 48;
+
+// Reads the counts from the header of an OFF file, to hold back the memory before the meshes are loaded
+static bool readOFFHeader(const QString &fileName, unsigned long long &nbVertices, unsigned long long &nbTriangles){
+    std::ifstream file(fileName.toStdString());
+    std::string magic;
+    file >> magic >> nbVertices >> nbTriangles;
+    return file.good() && magic == "OFF";
+}
+
+static bool readControlPoints(const QJsonObject &json, std::vector<Vec3Dd> &control){
+    if(!json.contains("control points") || !json["control points"].isArray()) return false;
+    const QJsonArray controlArray = json["control points"].toArray();
+
+    control.clear();
+    for(int i=0; i<controlArray.size(); i++){
+        QJsonArray singleControl = controlArray[i].toArray();
+        if(singleControl.size() != 3) return false;
+        control.push_back(Vec3Dd(singleControl[0].toDouble(), singleControl[1].toDouble(), singleControl[2].toDouble()));
+    }
+    return control.size() >= 4;     // a Catmull-Rom segment needs 4 control points
+}
+
+static QString meshFile(const QJsonObject &json, const QDir &caseDir){
+    if(!json.contains("mesh file") || !json["mesh file"].isString()) return QString();
+    return caseDir.absoluteFilePath(json["mesh file"].toString());     // relative to the case file
+}
+
+static bool saveOFF(const QString &fileName, const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles){
+    return FileIO::saveOFF(fileName.toStdString(), vertices, triangles);
+}
+
+static CaseResult runCase(const QString &caseFile, const QDir &outDir, const CasePlanner::PlanSpec &defaultSpec, bool isPiecesForced, MemoryBudget &budget, ThreadPool &pool){
+    const Clock::time_point t0 = Clock::now();
+    CaseResult result;
+    result.name = QFileInfo(caseFile).completeBaseName();
+
+    QFile loadFile(caseFile);
+    if(!loadFile.open(QIODevice::ReadOnly)){
+        result.error = "cannot open the case file";
+        return result;
+    }
+    const QJsonObject json = QJsonDocument::fromJson(loadFile.readAll()).object();
+    const QDir caseDir = QFileInfo(caseFile).absoluteDir();
+
+    const QJsonObject mandibleJson = json["mandible"].toObject();
+    const QJsonObject fibulaJson = json["fibula"].toObject();
+    const QString mandibleFile = meshFile(mandibleJson, caseDir);
+    const QString fibulaFile = meshFile(fibulaJson, caseDir);
+
+    std::vector<Vec3Dd> mandibleControl, fibulaControl;
+    if(!readControlPoints(mandibleJson, mandibleControl) || !readControlPoints(fibulaJson, fibulaControl)){
+        result.error = "needs at least 4 control points for the mandible and the fibula";
+        return result;
+    }
+
+    // The meshes themselves are only checked once loaded
+    unsigned long long nbVertices[2], nbTriangles[2];
+    if(!readOFFHeader(mandibleFile, nbVertices[0], nbTriangles[0]) || !readOFFHeader(fibulaFile, nbVertices[1], nbTriangles[1])){
+        result.error = "the mesh files must be OFF files";
+        return result;
+    }
+
+    CasePlanner::PlanSpec spec = defaultSpec;
+    const QJsonObject planJson = json["plan"].toObject();
+    if(!isPiecesForced && planJson.contains("pieces")) spec.nbPieces = static_cast<unsigned int>(std::max(1, planJson["pieces"].toInt()));
+    if(planJson.contains("optimise")) spec.isOptimise = planJson["optimise"].toBool();
+
+    // Quads are split in two, so count twice as many triangles to be safe
+    const unsigned long long bytes = (nbVertices[0] + nbVertices[1]) * bytesPerVertex + 2 * (nbTriangles[0] + nbTriangles[1]) * bytesPerTriangle;
+    budget.acquire(bytes);
+    result.estimatedBytes = bytes;
+
+    {
+        std::vector<Vec3Df> vertices;
+        std::vector<Triangle> triangles;
+
+        if(!FileIO::readOFF(mandibleFile.toStdString(), vertices, triangles)){
+            budget.release(bytes);
+            result.error = "the mandible isn't a valid OFF mesh";
+            return result;
+        }
+        MeshGeometry mandible(vertices, triangles);
+        if(!FileIO::readOFF(fibulaFile.toStdString(), vertices, triangles)){
+            budget.release(bytes);
+            result.error = "the fibula isn't a valid OFF mesh";
+            return result;
+        }
+        MeshGeometry fibula(vertices, triangles);
+        vertices.clear();
+        triangles.clear();
+
+        CasePlanner planner(std::move(mandible), mandibleControl, std::move(fibula), fibulaControl);
+        result.summary = planner.plan(spec, pool);
+        result.nbSegments = planner.getNbSegments();
+        planner.reportMemory(result.memory);
+
+        const QDir caseOut(outDir.absoluteFilePath(result.name));
+        outDir.mkpath(result.name);
+
+        bool isSaved = true;
+        planner.getMandibleCut(vertices, triangles);
+        isSaved &= saveOFF(caseOut.absoluteFilePath("mandible.off"), vertices, triangles);
+        // When pieces overlap the kept segments no longer line up with the pieces, so they can't be placed
+        if(result.nbSegments == result.summary.nbPlaced) for(unsigned int k=0; k<planner.getNbSegments(); k++){
+            planner.getSegment(k, vertices, triangles);
+            isSaved &= saveOFF(caseOut.absoluteFilePath(QString("segment_%1.off").arg(k)), vertices, triangles);
+        }
+
+        if(isSaved) result.isPlanned = true;
+        else result.error = "couldn't write the meshes";
+    }
+
+    budget.release(bytes);
+
+    result.duration = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return result;
+}
+
+static void writeMetrics(const QString &fileName, const std::vector<CaseResult> &results){
+    std::ofstream file(fileName.toStdString());
+    file << "case,status,pieces,placed,rms deviation (mm),max deviation (mm),fibula used (mm),approach (mm),segments,time (ms),memory (MB)" << std::endl;
+    for(unsigned int i=0; i<results.size(); i++){
+        const CaseResult &r = results[i];
+        file << r.name.toStdString() << ",";
+        if(!r.isPlanned){
+            file << "\"" << r.error.toStdString() << "\"" << std::endl;
+            continue;
+        }
+
+        const PieceCountEvaluator::PlanSummary &s = r.summary;
+        const char *status = "ok";
+        if(!s.isOnFibula) status = "too long for the fibula";
+        else if(s.nbPlaced != s.nbPieces) status = "fewer pieces";
+        else if(r.nbSegments != s.nbPlaced) status = "pieces overlap on the fibula";
+        file << status << ","
+             << s.nbPieces << "," << s.nbPlaced << ","
+             << std::fixed << std::setprecision(3) << s.rmsDeviation << "," << s.maxDeviation << ","
+             << std::setprecision(1) << s.fibulaLength << "," << s.approachShift << ","
+             << r.nbSegments << "," << r.duration << "," << static_cast<double>(r.memory.getAllocatedBytes()) / (1024.*1024.) << std::defaultfloat << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("batch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Plans and cuts the mandible and fibula of each case, several cases at a time.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("cases", "The case files (JSON).", "case.json...");
+    QCommandLineOption outOption(QStringList() << "o" << "out", "Where to write the meshes and metrics.csv.", "directory", "batch_out");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "How many cases to plan at once.", "n", "2");
+    QCommandLineOption memoryOption(QStringList() << "m" << "memory", "Memory for the meshes of the cases being planned (MB).", "MB", "2048");
+    QCommandLineOption piecesOption(QStringList() << "p" << "pieces", "The number of pieces, instead of the cases' plans.", "n");
+    QCommandLineOption optimiseOption("optimise", "Optimise the ghost plane positions in every case.");
+    QCommandLineOption memoryReportOption("memory-report", "Print the bytes held by each buffer of every case.");
+    parser.addOption(outOption);
+    parser.addOption(jobsOption);
+    parser.addOption(memoryOption);
+    parser.addOption(piecesOption);
+    parser.addOption(optimiseOption);
+    parser.addOption(memoryReportOption);
+    parser.process(app);
+
+    const QStringList cases = parser.positionalArguments();
+    if(cases.isEmpty()) parser.showHelp(1);
+
+    CasePlanner::PlanSpec spec;
+    const bool isPiecesForced = parser.isSet(piecesOption);
+    if(isPiecesForced) spec.nbPieces = static_cast<unsigned int>(std::max(1, parser.value(piecesOption).toInt()));
+    spec.isOptimise = parser.isSet(optimiseOption);
+
+    const bool isMemoryReport = parser.isSet(memoryReportOption);
+    const unsigned int nbJobs = static_cast<unsigned int>(std::max(1, parser.value(jobsOption).toInt()));
+    MemoryBudget budget(static_cast<unsigned long long>(std::max(1, parser.value(memoryOption).toInt())) * 1024 * 1024);
+
+    QDir outDir(parser.value(outOption));
+    if(!outDir.mkpath(".")){
+        std::cout << "Cannot create " << outDir.path().toStdString() << std::endl;
+        return 1;
+    }
+
+    // Each job plans one case at a time, the cutting stages share the global pool
+    const Clock::time_point t0 = Clock::now();
+    std::vector<CaseResult> results(static_cast<unsigned int>(cases.size()));
+    std::atomic<unsigned int> nextCase(0);
+    std::vector<std::thread> jobs;
+    for(unsigned int j=0; j<nbJobs; j++){
+        jobs.push_back(std::thread([&](){
+            unsigned int i;
+            while((i = nextCase++) < results.size()){
+                results[i] = runCase(cases[static_cast<int>(i)], outDir, spec, isPiecesForced, budget, ThreadPool::global());
+                const CaseResult &r = results[i];
+                if(r.isPlanned) print(QString("%1 : %2 pieces in %3 ms").arg(r.name).arg(r.summary.nbPlaced).arg(r.duration, 0, 'f', 0));
+                else print(QString("%1 : %2").arg(r.name, r.error));
+
+                // The budget only has an estimate to go on, say when a case didn't fit in it
+                if(r.memory.getAllocatedBytes() > r.estimatedBytes && r.estimatedBytes != 0){
+                    print(QString("%1 : %2 MB of buffers, over the %3 MB held back for it").arg(r.name)
+                          .arg(static_cast<double>(r.memory.getAllocatedBytes()) / (1024.*1024.), 0, 'f', 1).arg(static_cast<double>(r.estimatedBytes) / (1024.*1024.), 0, 'f', 1));
+                }
+                if(isMemoryReport && r.isPlanned){
+                    std::ostringstream report;
+                    r.memory.print(report);
+                    print(r.name + " :\n" + QString::fromStdString(report.str()));
+                }
+            }
+        }));
+    }
+    for(unsigned int j=0; j<jobs.size(); j++) jobs[j].join();
+
+    const double minutes = std::chrono::duration<double>(Clock::now() - t0).count() / 60.0;
+    writeMetrics(outDir.absoluteFilePath("metrics.csv"), results);
+
+    unsigned int nbPlanned = 0;
+    for(unsigned int i=0; i<results.size(); i++){
+        if(results[i].isPlanned) nbPlanned++;
+    }
+    std::cout << nbPlanned << "/" << results.size() << " cases planned in " << minutes * 60.0 << " s : "
+              << (minutes > 0 ? static_cast<double>(nbPlanned) / minutes : 0.0) << " cases per minute" << std::endl;
+    if(MemoryTracker::isEnabled()) std::cout << "Peak memory " << static_cast<double>(MemoryTracker::getPeakBytes()) / (1024.*1024.) << " MB" << std::endl;
+
+    return nbPlanned == results.size() ? 0 : 1;
+}
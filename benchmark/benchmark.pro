@@ -0,0 +1,23 @@
+# Microbenchmarks of the planning code, run outside of the viewers.
+# benchmark --json results.json saves every stage timing to compare commits.
+
+TEMPLATE = app
+TARGET   = benchmark
+
+CONFIG += console warn_on thread c++14
+CONFIG -= qt app_bundle
+
+HEADERS  = \
+    stages.h \
+    stagetimer.h
+SOURCES  = \
+    main.cpp \
+    stages.cpp \
+    stagetimer.cpp
+
+# The bundled meshes, and the commit the results are saved with
+DEFINES += MEDMAX_DATA_DIR=\\\"$$PWD/..\\\"
+BENCHMARK_COMMIT = $$system(git -C $$PWD rev-parse --short HEAD)
+DEFINES += BENCHMARK_COMMIT=\\\"$$BENCHMARK_COMMIT\\\"
+
+include( ../core/core.pri )
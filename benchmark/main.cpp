@@ -0,0 +1,203 @@
+#include "curvegeometry.h"
+#include "stages.h"
+#include "perfcounters.h"
+#include "threadpool.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#ifndef MEDMAX_DATA_DIR
+#define MEDMAX_DATA_DIR ".."
+#endif
+#ifndef BENCHMARK_COMMIT
+#define BENCHMARK_COMMIT ""
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// The linear search CurveGeometry::indexForLength used before the arc length table, kept as the reference
+static double legacyLength(const std::vector<Vec3Dd> &curve, unsigned int indexS, unsigned int indexE){
+    return sqrt(pow(curve[indexE][0] - curve[indexS][0], 2) + pow(curve[indexE][1] - curve[indexS][1], 2) + pow(curve[indexE][2] - curve[indexS][2], 2));
+}
+
+static unsigned int legacyClosest(const std::vector<Vec3Dd> &curve, double target, unsigned int indexS, unsigned int a, unsigned int b){
+    double aTarget = std::abs(target - legacyLength(curve, indexS, indexS+a));
+    double bTarget = std::abs(target - legacyLength(curve, indexS, indexS+b));
+
+    if(aTarget < bTarget) return a;
+    return b;
+}
+
+static unsigned int legacyIndexForLength(const std::vector<Vec3Dd> &curve, unsigned int nbU, unsigned int indexS, double length){
+    unsigned int i=0;
+
+    if(length > 0){
+        while(indexS+i < nbU-1 && legacyLength(curve, indexS, indexS+i) < length) i++;
+        if(i!=0) i = legacyClosest(curve, length, indexS, i, i-1);
+    }
+    else{
+        while(indexS+i > 0 && legacyLength(curve, indexS, indexS+i) < std::abs(length)) i--;
+        if(i!=nbU-1) i = legacyClosest(curve, length, indexS, i, i+1);
+    }
+
+    return indexS+i;
+}
+
+static double msSince(const Clock::time_point &t0){
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Time both searches on the same random queries and make sure they agree
+static bool benchIndexForLength(const std::string &name, const std::vector<Vec3Dd> &control, unsigned int nbU, double maxLength){
+    CurveGeometry curve(control);
+    curve.generateCatmull(nbU);
+
+    const unsigned int nbQueries = 200000;
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned int> randomIndex(0, nbU-2);
+    std::uniform_real_distribution<double> randomLength(-maxLength, maxLength);
+
+    std::vector<unsigned int> starts(nbQueries);
+    std::vector<double> lengths(nbQueries);
+    for(unsigned int i=0; i<nbQueries; i++){
+        starts[i] = randomIndex(generator);
+        lengths[i] = randomLength(generator);
+    }
+
+    std::vector<unsigned int> legacy(nbQueries), table(nbQueries);
+
+    Clock::time_point t0 = Clock::now();
+    for(unsigned int i=0; i<nbQueries; i++) legacy[i] = legacyIndexForLength(curve.getCurve(), nbU, starts[i], lengths[i]);
+    double legacyTime = msSince(t0);
+
+    t0 = Clock::now();
+    for(unsigned int i=0; i<nbQueries; i++) table[i] = curve.indexForLength(starts[i], lengths[i]);
+    double tableTime = msSince(t0);
+
+    unsigned int nbDifferent = 0;
+    for(unsigned int i=0; i<nbQueries; i++){
+        if(legacy[i] != table[i]) nbDifferent++;
+    }
+
+    std::cout << name << " (" << nbU << " samples, " << curve.getTotalLength() << " long) : "
+              << "linear " << legacyTime * 1e6 / nbQueries << " ns/query, "
+              << "arc length table " << tableTime * 1e6 / nbQueries << " ns/query, "
+              << "x" << legacyTime / tableTime << std::endl;
+    if(nbDifferent != 0) std::cout << "  " << nbDifferent << " different indicies !" << std::endl;
+
+    return nbDifferent == 0;
+}
+
+static void printUsage(){
+    std::cout << "benchmark [options]" << std::endl
+              << "  --json <file>     write every timing to file, to compare runs (commits)" << std::endl
+              << "  --label <text>    saved in the json file (the commit by default)" << std::endl
+              << "  --data <dir>      where Mand_B.off and Fibula_G.off are (" << MEDMAX_DATA_DIR << ")" << std::endl
+              << "  --warmup <n>      untimed runs of each stage (3)" << std::endl
+              << "  --repetitions <n> timed runs of each stage (15)" << std::endl
+              << "  --planes <n>      the most planes to cut with, from 2 in steps of 2 (20)" << std::endl
+              << "  --file-order      keep the verticies and triangles in the order of the files, to compare with the reordered meshes" << std::endl
+              << "Scaling (instead of the bundled meshes, the meshes come from meshgen) :" << std::endl
+              << "  --scale-mandible <file>  a bigger mandible, can be given several times" << std::endl
+              << "  --scale-fibula <file>    a bigger fibula, can be given several times" << std::endl
+              << "  --scale-planes <n>       the planes to cut them with (6)" << std::endl
+              << "  --csv <file>      also write the timings as csv, to plot them" << std::endl
+              << "  --trace <file>    save the hot path timings as a Chrome trace (built with CONFIG+=tracing)" << std::endl
+              << "  --counters        count cycles, instructions, LLC and branch misses of each stage (Linux perf_event_open)" << std::endl;
+}
+
+static bool saveResults(const std::string &fileName, const StageTimer &timer, bool isJSON, const std::string &label){
+    std::ofstream file(fileName);
+    if(!file.is_open()){
+        std::cout << fileName << " cannot be opened" << std::endl;
+        return false;
+    }
+    if(isJSON) timer.writeJSON(file, label, BENCHMARK_COMMIT, ThreadPool::global().getNbThreads());
+    else timer.writeCSV(file);
+    std::cout << "Saved in " << fileName << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string jsonFile, csvFile, traceFile;
+    std::vector<std::string> scaleMandible, scaleFibula;
+    unsigned int scalePlanes = 6;
+    std::string label = BENCHMARK_COMMIT;
+    std::string dataDir = MEDMAX_DATA_DIR;
+    unsigned int warmup = 3;
+    unsigned int repetitions = 15;
+    unsigned int maxPlanes = 20;
+    bool isReordered = true;
+
+    for(int i=1; i<argc; i++){
+        const bool hasValue = i+1 < argc;
+        if(!strcmp(argv[i], "--json") && hasValue) jsonFile = argv[++i];
+        else if(!strcmp(argv[i], "--label") && hasValue) label = argv[++i];
+        else if(!strcmp(argv[i], "--data") && hasValue) dataDir = argv[++i];
+        else if(!strcmp(argv[i], "--warmup") && hasValue) warmup = static_cast<unsigned int>(atoi(argv[++i]));
+        else if(!strcmp(argv[i], "--repetitions") && hasValue) repetitions = static_cast<unsigned int>(std::max(1, atoi(argv[++i])));
+        else if(!strcmp(argv[i], "--planes") && hasValue) maxPlanes = static_cast<unsigned int>(std::max(2, atoi(argv[++i])));
+        else if(!strcmp(argv[i], "--scale-mandible") && hasValue) scaleMandible.push_back(argv[++i]);
+        else if(!strcmp(argv[i], "--scale-fibula") && hasValue) scaleFibula.push_back(argv[++i]);
+        else if(!strcmp(argv[i], "--scale-planes") && hasValue) scalePlanes = static_cast<unsigned int>(std::max(2, atoi(argv[++i])));
+        else if(!strcmp(argv[i], "--csv") && hasValue) csvFile = argv[++i];
+        else if(!strcmp(argv[i], "--trace") && hasValue) traceFile = argv[++i];
+        else if(!strcmp(argv[i], "--counters")) PerfCounters::setEnabled(true);
+        else if(!strcmp(argv[i], "--file-order")) isReordered = false;
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+    if(PerfCounters::isEnabled() && !PerfCounters::forThread().isAvailable()) std::cout << "The hardware counters can't be opened (no PMU, or /proc/sys/kernel/perf_event_paranoid is too high), timing only" << std::endl;
+
+    std::vector<Vec3Dd> mandible;
+    mandible.push_back(Vec3Dd(-56.9335, -13.9973, 8.25454));
+    mandible.push_back(Vec3Dd(-50.8191, -20.195, -19.53));
+    mandible.push_back(Vec3Dd(-40.155, -34.5957, -50.7005));
+    mandible.push_back(Vec3Dd(-27.6007, -69.2743, -67.6769));
+    mandible.push_back(Vec3Dd(0, -85.966, -68.3154));
+    mandible.push_back(Vec3Dd(26.7572, -69.0705, -65.6261));
+    mandible.push_back(Vec3Dd(40.3576, -34.3609, -50.7634));
+    mandible.push_back(Vec3Dd(46.2189, -21.3245, -17.9009));
+    mandible.push_back(Vec3Dd(52.3669, -15.4613, 8.70223));
+
+    std::vector<Vec3Dd> fibula;
+    fibula.push_back(Vec3Dd(108.241, 69.6891, -804.132));
+    fibula.push_back(Vec3Dd(97.122, 82.1788, -866.868));
+    fibula.push_back(Vec3Dd(93.5364, 90.1045, -956.126));
+    fibula.push_back(Vec3Dd(83.3966, 92.5807, -1069.7));
+    fibula.push_back(Vec3Dd(80.9, 90.1, -1155));
+    fibula.push_back(Vec3Dd(86.4811, 90.9929, -1199.7));
+
+    StageTimer timer(warmup, repetitions);
+    bool isIdentical = true;
+    if(scaleMandible.size()!=0 || scaleFibula.size()!=0){
+        if(scaleMandible.size()!=0 && !benchScaling(timer, "mandible", scaleMandible, mandible, scalePlanes, isReordered)) return 1;
+        if(scaleFibula.size()!=0 && !benchScaling(timer, "fibula", scaleFibula, fibula, scalePlanes, isReordered)) return 1;
+    }
+    else{
+        isIdentical &= benchIndexForLength("mandible", mandible, 100, 100);
+        isIdentical &= benchIndexForLength("mandible", mandible, 2000, 100);
+        isIdentical &= benchIndexForLength("fibula", fibula, 2000, 100);
+        isIdentical &= benchIndexForLength("fibula", fibula, 20000, 100);
+        std::cout << std::endl;
+
+        if(!benchStages(timer, dataDir, mandible, fibula, maxPlanes, isReordered)) return 1;
+    }
+    std::cout << std::endl;
+    timer.printTable(std::cout);
+
+    if(!jsonFile.empty() && !saveResults(jsonFile, timer, true, label)) return 1;
+    if(!csvFile.empty() && !saveResults(csvFile, timer, false, label)) return 1;
+    if(!traceFile.empty() && !Trace::save(traceFile)) return 1;
+
+    return isIdentical ? 0 : 1;
+}
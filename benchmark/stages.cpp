@@ -0,0 +1,425 @@
+#include "stages.h"
+#include "compactmesh.h"
+#include "curvegeometry.h"
+#include "meshgeometry.h"
+#include "meshreader.h"
+#include "meshreorder.h"
+#include "threadpool.h"
+#include "vec3kernels.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+static const double planeSize = 40.0;
+static const double ghostPlaneSize = 25.0;
+static const double fibulaGap = 10.0;       // the bone left between two pieces (mm)
+static volatile unsigned int resultSink;        // so the timed calls aren't optimised out
+
+// Same as the viewers : the plane follows the rotation minimising frame
+static CutPlane curvePlane(const CurveGeometry &curve, unsigned int index, double size){
+    const Vec3Dd t = curve.tangent(index);
+    const Vec3Dd &n = curve.getFrameNormal(index);
+    return CutPlane(AffineFrame(curve.getPoint(index), n, Vec3Dd::crossProduct(t, n), t), size);
+}
+
+// The left and right planes first, then the ghost planes spread evenly between them
+static std::vector<CutPlane> mandiblePlanes(const CurveGeometry &curve, unsigned int nbPlanes){
+    std::vector<unsigned int> indexes;
+    for(unsigned int i=0; i<nbPlanes; i++) indexes.push_back(curve.indexAtLength(curve.getTotalLength() * (0.1 + 0.8 * i / (nbPlanes-1))));
+
+    std::vector<CutPlane> planes;
+    planes.push_back(curvePlane(curve, indexes.front(), planeSize));
+    planes.push_back(curvePlane(curve, indexes.back(), planeSize));
+    for(unsigned int i=1; i+1<nbPlanes; i++) planes.push_back(curvePlane(curve, indexes[i], planeSize));
+    return planes;
+}
+
+// The ghost planes come in pairs in the fibula : nbPlanes/2 pieces with a gap between them
+static std::vector<CutPlane> fibulaPlanes(const CurveGeometry &curve, unsigned int nbPlanes){
+    const unsigned int nbPieces = nbPlanes/2;
+    const double start = 0.15 * curve.getTotalLength();
+    const double end = 0.85 * curve.getTotalLength();
+    const double pieceLength = (end - start - fibulaGap * (nbPieces-1)) / nbPieces;
+
+    std::vector<CutPlane> ends;
+    for(unsigned int k=0; k<nbPieces; k++){
+        const double a = start + k * (pieceLength + fibulaGap);
+        ends.push_back(curvePlane(curve, curve.indexAtLength(a), k==0 ? planeSize : ghostPlaneSize));
+        ends.push_back(curvePlane(curve, curve.indexAtLength(a + pieceLength), k==nbPieces-1 ? planeSize : ghostPlaneSize));
+    }
+
+    std::vector<CutPlane> planes;
+    planes.push_back(ends.front());
+    planes.push_back(ends.back());
+    planes.insert(planes.end(), ends.begin()+1, ends.end()-1);
+    return planes;
+}
+
+// The readers say which file they open, keep it out of the output
+static bool openQuietly(const std::string &fileName, std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles){
+    std::ostringstream sink;
+    std::streambuf *out = std::cout.rdbuf(sink.rdbuf());
+    const bool isOpen = FileIO::openMesh(fileName, vertices, triangles);
+    std::cout.rdbuf(out);
+    if(!isOpen) std::cout << sink.str();
+    return isOpen;
+}
+
+static bool isPLY(const std::string &fileName){
+    return fileName.size() >= 4 && fileName.compare(fileName.size()-4, 4, ".ply") == 0;
+}
+
+static void benchCurve(StageTimer &timer, const std::string &name, const std::vector<Vec3Dd> &control, double maxSpacing){
+    CurveGeometry curve(control);
+    unsigned int nbU = 0;
+    timer.time("generateAdaptiveCatmull", name, 0, [&](){ curve.generateAdaptiveCatmull(0.01, maxSpacing, nbU); });
+
+    // As many samples as the adaptive sampling, to compare the two
+    const unsigned int nbAdaptive = nbU;
+    timer.time("generateCatmull", name, 0, [&](){ nbU = nbAdaptive; curve.generateCatmull(nbU); });
+
+    const unsigned int nbQueries = 10000;
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned int> randomIndex(0, nbU-2);
+    std::uniform_real_distribution<double> randomLength(-100, 100);
+    std::vector<unsigned int> starts(nbQueries);
+    std::vector<double> lengths(nbQueries);
+    for(unsigned int i=0; i<nbQueries; i++){
+        starts[i] = randomIndex(generator);
+        lengths[i] = randomLength(generator);
+    }
+
+    unsigned int sum = 0;
+    timer.time("indexForLength", name, 0, [&](){
+        for(unsigned int i=0; i<nbQueries; i++) sum += curve.indexForLength(starts[i], lengths[i]);
+    }, nbQueries);
+    resultSink = sum;
+}
+
+// Reordering again costs about the same, so it's timed on the mesh itself. The ACMR stands in for the drawing, there's no OpenGL here.
+static void benchReorder(StageTimer &timer, const std::string &name, MeshGeometry &mesh){
+    const unsigned int nbVertices = static_cast<unsigned int>(mesh.getVertices().size());
+    const double fileACMR = MeshReorder::getACMR(mesh.getTriangles(), nbVertices);
+    const std::vector<Vec3Df> loadedVertices = mesh.getVertices();
+    const std::vector<Triangle> loadedTriangles = mesh.getTriangles();
+    bool isReordered = false;
+    timer.time("reorderForLocality", name, 0, [&](){
+        mesh.reorderForLocality(isReordered);
+        isReordered = true;
+    });
+    std::cout << name << " vertex cache misses per triangle : " << fileACMR << " in the file order, " << MeshReorder::getACMR(mesh.getTriangles(), nbVertices) << " reordered" << std::endl;
+
+    std::vector<Vec3Df> vertices;
+    std::vector<Triangle> triangles;
+    mesh.getInOriginalOrder(vertices, triangles);
+    if(vertices != loadedVertices || triangles != loadedTriangles) std::cout << name << " : the reordered mesh doesn't give back the mesh as it was loaded !" << std::endl;
+}
+
+/*
+ * The vertex normals and the bounding box, with the SSE kernels and the scalar loops, then the normals gathered in parallel
+ * and updated around 1% of the verticies. They must all give the same values.
+*/
+static void benchKernels(StageTimer &timer, const std::string &name, MeshGeometry &mesh, ThreadPool &pool){
+    const std::vector<Vec3Df> &vertices = mesh.getVertices();
+    const std::vector<Triangle> &triangles = mesh.getTriangles();
+    std::vector<Vec3Df> normals, scalarNormals;
+    Vec3Df bbMin, bbMax, scalarMin, scalarMax;
+
+    timer.time("vertexNormals", name, 0, [&](){ normals.assign(vertices.size(), Vec3Df()); }, [&](){
+        Vec3Kernels::accumulateTriangleNormals(vertices, triangles, normals);
+        Vec3Kernels::normalize(normals);
+    });
+    timer.time("vertexNormals scalar", name, 0, [&](){ scalarNormals.assign(vertices.size(), Vec3Df()); }, [&](){
+        Vec3Kernels::Scalar::accumulateTriangleNormals(vertices, triangles, scalarNormals);
+        Vec3Kernels::Scalar::normalize(scalarNormals);
+    });
+    timer.time("boundingBox", name, 0, [&](){ Vec3Kernels::boundingBox(vertices, bbMin, bbMax); });
+    timer.time("boundingBox scalar", name, 0, [&](){ Vec3Kernels::Scalar::boundingBox(vertices, scalarMin, scalarMax); });
+
+    if(normals != scalarNormals || bbMin != scalarMin || bbMax != scalarMax) std::cout << name << " : the SSE kernels and the scalar loops differ !" << std::endl;
+
+    timer.time("vertexNormals gather", name, 0, [&](){ mesh.recomputeNormals(pool); });
+    if(mesh.getNormals() != normals) std::cout << name << " : the gathered normals differ from the scattered ones !" << std::endl;
+
+    // Neighbours in memory are neighbours on the mesh once it's reordered
+    const std::vector<Vec3Df> original = mesh.getVertices();
+    std::vector<unsigned int> moved;
+    for(unsigned int i=0; i<original.size()/100; i++){
+        moved.push_back(i);
+        mesh.getVertices()[i] += Vec3Df(0.5f, 0.f, 0.f);
+    }
+    timer.time("updateNormals 1%", name, 0, [&](){ mesh.updateNormals(moved); });
+    const std::vector<Vec3Df> updated = mesh.getNormals();
+    mesh.recomputeNormals(pool);
+    if(mesh.getNormals() != updated) std::cout << name << " : the updated normals differ from the recomputed ones !" << std::endl;
+
+    mesh.getVertices() = original;
+    mesh.recomputeNormals(pool);
+}
+
+// The bytes per triangle of the arrays MeshGeometry works on against the packed forms, and how much packing loses
+static void benchStorage(StageTimer &timer, const std::string &name, const MeshGeometry &mesh){
+    MemoryReport arrays;
+    arrays.add("vertices", mesh.getVertices());
+    arrays.add("normals", mesh.getNormals());
+    arrays.add("triangles", mesh.getTriangles());
+
+    CompactMesh packed, quantised;
+    timer.time("pack", name, 0, [&](){ packed = mesh.pack(false); });
+    timer.time("pack quantised", name, 0, [&](){ quantised = mesh.pack(true); });
+    MeshGeometry unpacked;
+    timer.time("unpack quantised", name, 0, [&](){ unpacked = MeshGeometry(quantised); });
+
+    MemoryReport packedReport, quantisedReport;
+    packed.reportMemory(packedReport);
+    quantised.reportMemory(quantisedReport);
+
+    float maxPosition = 0;
+    double maxAngle = 0;
+    const std::vector<Vec3Df> &normals = mesh.getNormals();
+    for(unsigned int i=0; i<mesh.getVertices().size(); i++){
+        maxPosition = std::max(maxPosition, (quantised.getPosition(i) - mesh.getVertices()[i]).getLength());
+        if(i < normals.size() && normals[i].getSquaredLength() > 0){
+            const double cosine = Vec3Df::dotProduct(quantised.getNormal(i), normals[i]) / normals[i].getLength();
+            maxAngle = std::max(maxAngle, std::acos(std::min(1.0, std::max(-1.0, cosine))) * 180.0 / M_PI);
+        }
+    }
+
+    const double nbTriangles = static_cast<double>(std::max<size_t>(1, mesh.getTriangles().size()));
+    std::cout << name << " storage : " << arrays.getUsedBytes() / nbTriangles << " bytes per triangle as arrays (a Triangle is " << sizeof(Triangle)
+              << " bytes), " << packedReport.getUsedBytes() / nbTriangles << " packed, " << quantisedReport.getUsedBytes() / nbTriangles
+              << " quantised ; quantised position error " << maxPosition << " (bound " << quantised.getMaxPositionError()
+              << "), normal error " << maxAngle << " degrees" << std::endl;
+    if(maxPosition > quantised.getMaxPositionError()) std::cout << name << " : the quantised positions are further out than getMaxPositionError !" << std::endl;
+}
+
+// The cutting stages one at a time. Each setup redoes the stages before, as the later stages change the flooding.
+static void benchCut(StageTimer &timer, const std::string &name, MeshGeometry &mesh, const std::vector<CutPlane> &planes, Side side, ThreadPool &pool){
+    const unsigned int nbPlanes = static_cast<unsigned int>(planes.size());
+    auto flood = [&](){
+        mesh.seedPlaneSides();
+        mesh.floodFromIntersections();
+        mesh.mergeFlood();
+    };
+
+    timer.time("planeIntersection", name, nbPlanes, [&](){
+        mesh.setCutPlanes(std::vector<CutPlane>(), side);     // forget the saved intersections
+        mesh.intersectPlanes(pool);
+        mesh.setCutPlanes(planes, side);
+    }, [&](){ mesh.intersectPlanes(pool); });
+
+    timer.time("floodNeighbour/mergeFlood", name, nbPlanes, flood);
+    timer.time("cutMesh", name, nbPlanes, flood, [&](){ mesh.cutMesh(); });
+    timer.time("createSmoothedTriangles", name, nbPlanes, [&](){ flood(); mesh.cutMesh(); }, [&](){ mesh.createSmoothedTriangles(); });
+    timer.time("updateSmoothedNormals", name, nbPlanes, [&](){ flood(); mesh.cutMesh(); mesh.createSmoothedTriangles(); }, [&](){ mesh.updateSmoothedNormals(); });
+}
+
+// The intersections from the slab index against testing every triangle : the same cut, from how many candidates
+static void benchSlabIndex(StageTimer &timer, const std::string &name, MeshGeometry &mesh, const CurveGeometry &curve, const std::vector<CutPlane> &planes, Side side, ThreadPool &pool){
+    const unsigned int nbPlanes = static_cast<unsigned int>(planes.size());
+    size_t nbCandidates = 0;
+    unsigned int nbFullScans = 0;
+    std::vector<unsigned int> candidates;
+    for(unsigned int i=0; i<nbPlanes; i++){
+        if(mesh.getSlabIndex().getCandidates(planes[i], candidates)) nbCandidates += candidates.size();
+        else nbFullScans++;
+    }
+
+    mesh.setCutPlanes(std::vector<CutPlane>(), side);
+    mesh.cut(planes, side, pool);
+    const std::vector<unsigned int> indexed = mesh.getTrianglesCut();
+
+    mesh.clearSlabIndex();
+    timer.time("planeIntersectionScan", name, nbPlanes, [&](){
+        mesh.setCutPlanes(std::vector<CutPlane>(), side);
+        mesh.intersectPlanes(pool);
+        mesh.setCutPlanes(planes, side);
+    }, [&](){ mesh.intersectPlanes(pool); });
+    mesh.cut(planes, side, pool);
+    if(mesh.getTrianglesCut() != indexed) std::cout << "  " << nbPlanes << " " << name << " planes : the slab index doesn't give the same cut as testing every triangle" << std::endl;
+    mesh.buildSlabIndex(curve, planeSize, pool);
+
+    const unsigned int nbIndexed = nbPlanes - nbFullScans;
+    std::cout << "  " << nbPlanes << " " << name << " planes : " << (nbIndexed!=0 ? nbCandidates / nbIndexed : 0) << " candidate triangles per plane (of "
+              << mesh.getTriangles().size() << "), " << nbFullScans << " tested every triangle" << std::endl;
+}
+
+// Going back to planes already cut : the cut from the cache has to leave the mesh as cutting again does
+static void benchCutCache(StageTimer &timer, const std::string &name, MeshGeometry &mesh, const std::vector<CutPlane> &planes, const std::vector<CutPlane> &otherPlanes, Side side, ThreadPool &pool){
+    const unsigned int nbPlanes = static_cast<unsigned int>(planes.size());
+    mesh.setCutCacheSize(32 << 20);
+    mesh.cut(planes, side, pool);
+    const std::vector<int> flooding = mesh.getFlooding();
+    const std::vector<unsigned int> trianglesCut = mesh.getTrianglesCut();
+    const std::vector<Vec3Df> smoothedVertices = mesh.getSmoothedVertices();
+    const std::vector<Vec3Df> smoothedNormals = mesh.getSmoothedNormals();
+
+    mesh.cut(otherPlanes, side, pool);
+    mesh.cut(planes, side, pool);
+    if(mesh.getFlooding() != flooding || mesh.getTrianglesCut() != trianglesCut || mesh.getSmoothedVertices() != smoothedVertices || mesh.getSmoothedNormals() != smoothedNormals){
+        std::cout << "  " << nbPlanes << " " << name << " planes : the cut from the cache isn't the same as cutting again" << std::endl;
+    }
+
+    timer.time("restoreCut", name, nbPlanes, [&](){ mesh.cut(otherPlanes, side, pool); }, [&](){ mesh.cut(planes, side, pool); });
+    const CutCache &cache = mesh.getCutCache();
+    std::cout << "  " << nbPlanes << " " << name << " planes : " << cache.getNbEntries() << " cuts cached in " << cache.getBytes() / 1024 << " KB, "
+              << cache.getNbHits() << " hits, " << cache.getNbMisses() << " misses" << std::endl;
+    mesh.setCutCacheSize(0);
+}
+
+// The largest angle (degrees) between the smoothed normals and the normals recomputed from scratch on the kept triangles of the smoothed mesh
+static double smoothedNormalsError(const MeshGeometry &mesh){
+    const std::vector<Vec3Df> &positions = mesh.getSmoothedVertices();
+    const std::vector<Triangle> &triangles = mesh.getTriangles();
+    const std::vector<unsigned int> &kept = mesh.getTrianglesCut();
+    std::vector<Vec3Df> normals(positions.size());
+    for(unsigned int i=0; i<kept.size(); i++){
+        const Triangle &t = triangles[kept[i]];
+        Vec3Df n = Vec3Df::crossProduct(positions[t.getVertex(1)] - positions[t.getVertex(0)], positions[t.getVertex(2)] - positions[t.getVertex(0)]);
+        n.normalize();
+        for(unsigned int j=0; j<3; j++) normals[t.getVertex(j)] += n;
+    }
+
+    double maxAngle = 0;
+    for(unsigned int i=0; i<kept.size(); i++){
+        for(unsigned int j=0; j<3; j++){
+            const unsigned int v = triangles[kept[i]].getVertex(j);
+            Vec3Dd n(normals[v][0], normals[v][1], normals[v][2]);
+            const Vec3Df &smoothed = mesh.getSmoothedNormals()[v];
+            if(n.normalize() == 0) continue;
+            const double cosine = Vec3Dd::dotProduct(n, Vec3Dd(smoothed[0], smoothed[1], smoothed[2])) / Vec3Dd(smoothed[0], smoothed[1], smoothed[2]).getLength();
+            maxAngle = std::max(maxAngle, std::acos(std::min(1.0, std::max(-1.0, cosine))) * 180.0 / M_PI);
+        }
+    }
+    return maxAngle;
+}
+
+bool benchStages(StageTimer &timer, const std::string &dataDir, const std::vector<Vec3Dd> &mandibleControl, const std::vector<Vec3Dd> &fibulaControl, unsigned int maxPlanes, bool isReordered){
+    const std::string names[2] = {"mandible", "fibula"};
+    const std::string files[2] = {dataDir + "/Mand_B.off", dataDir + "/Fibula_G.off"};
+    std::vector<Vec3Df> vertices[2];
+    std::vector<Triangle> triangles[2];
+
+    for(unsigned int i=0; i<2; i++){
+        if(!openQuietly(files[i], vertices[i], triangles[i])) return false;
+        std::cout << names[i] << " : " << vertices[i].size() << " verticies, " << triangles[i].size() << " triangles" << std::endl;
+        timer.setNbTriangles(triangles[i].size());
+
+        std::vector<Vec3Df> v;
+        std::vector<Triangle> t;
+        timer.time("openOFF", names[i], 0, [&](){ openQuietly(files[i], v, t); });
+
+        if(isReordered){
+            MeshGeometry mesh(vertices[i], triangles[i]);
+            benchReorder(timer, names[i], mesh);
+            vertices[i] = mesh.getVertices();
+            triangles[i] = mesh.getTriangles();
+        }
+    }
+
+    // Mesh::init
+    MeshGeometry meshes[2];
+    for(unsigned int i=0; i<2; i++){
+        timer.setNbTriangles(triangles[i].size());
+        timer.time("init", names[i], 0, [&](){ meshes[i] = MeshGeometry(vertices[i], triangles[i]); }, [&](){
+            meshes[i].collectOneRings();
+            meshes[i].recomputeNormals();
+        });
+    }
+    for(unsigned int i=0; i<2; i++){
+        timer.setNbTriangles(triangles[i].size());
+        benchKernels(timer, names[i], meshes[i], ThreadPool::global());
+        benchStorage(timer, names[i], meshes[i]);
+    }
+
+    timer.setNbTriangles(0);
+    benchCurve(timer, "mandible", mandibleControl, 1.0);
+    benchCurve(timer, "fibula", fibulaControl, 0.5);
+
+    CurveGeometry mandibleCurve(mandibleControl);
+    CurveGeometry fibulaCurve(fibulaControl);
+    unsigned int nbU = 0;
+    mandibleCurve.generateAdaptiveCatmull(0.01, 1.0, nbU);
+    fibulaCurve.generateAdaptiveCatmull(0.01, 0.5, nbU);
+
+    ThreadPool &pool = ThreadPool::global();
+    MeshGeometry &mandible = meshes[0];
+    MeshGeometry &fibula = meshes[1];
+
+    const CurveGeometry *curves[2] = {&mandibleCurve, &fibulaCurve};
+    for(unsigned int i=0; i<2; i++){
+        timer.setNbTriangles(meshes[i].getTriangles().size());
+        timer.time("buildSlabIndex", names[i], 0, [&](){ meshes[i].buildSlabIndex(*curves[i], planeSize, pool); });
+        std::cout << names[i] << " slab index : " << meshes[i].getSlabIndex().getBytes() / 1024 << " KB for " << curves[i]->getNbU() << " samples (every "
+                  << meshes[i].getSlabIndex().getStride() << " kept)" << std::endl;
+    }
+
+    for(unsigned int nbPlanes=2; nbPlanes<=maxPlanes; nbPlanes+=2){
+        const std::vector<CutPlane> fibPlanes = fibulaPlanes(fibulaCurve, nbPlanes);
+        timer.setNbTriangles(fibula.getTriangles().size());
+        benchCut(timer, "fibula", fibula, fibPlanes, Side::EXTERIOR, pool);
+        benchSlabIndex(timer, "fibula", fibula, fibulaCurve, fibPlanes, Side::EXTERIOR, pool);
+        fibula.cut(fibPlanes, Side::EXTERIOR, pool);
+        const double fibulaError = smoothedNormalsError(fibula);
+        if(fibulaError > 0.01) std::cout << "  " << nbPlanes << " fibula planes : the smoothed normals are up to " << fibulaError << " degrees out" << std::endl;
+        if(fibula.getSegmentsConserved().size() != nbPlanes/2) std::cout << "  " << nbPlanes << " fibula planes : kept " << fibula.getSegmentsConserved().size() << " segments instead of " << nbPlanes/2 << std::endl;
+        benchCutCache(timer, "fibula", fibula, fibPlanes, fibulaPlanes(fibulaCurve, nbPlanes+2), Side::EXTERIOR, pool);
+
+        MeshGeometry::SegmentTransfer transfer;
+        timer.time("sendToMandible", "fibula", nbPlanes, [&](){ fibula.exportSegments(transfer); });
+
+        const std::vector<CutPlane> mandPlanes = mandiblePlanes(mandibleCurve, nbPlanes);
+        timer.setNbTriangles(mandible.getTriangles().size());
+        benchCut(timer, "mandible", mandible, mandPlanes, Side::INTERIOR, pool);
+        benchSlabIndex(timer, "mandible", mandible, mandibleCurve, mandPlanes, Side::INTERIOR, pool);
+        mandible.cut(mandPlanes, Side::INTERIOR, pool);
+        const double mandibleError = smoothedNormalsError(mandible);
+        if(mandibleError > 0.01) std::cout << "  " << nbPlanes << " mandible planes : the smoothed normals are up to " << mandibleError << " degrees out" << std::endl;
+        benchCutCache(timer, "mandible", mandible, mandPlanes, mandiblePlanes(mandibleCurve, nbPlanes+2), Side::INTERIOR, pool);
+
+        std::vector<Vec3Df> placedVertices, placedNormals;
+        timer.time("recieveInfoFromFibula", "mandible", nbPlanes, [&](){ mandible.placeSegments(transfer, placedVertices, placedNormals); });
+    }
+
+    return true;
+}
+
+bool benchScaling(StageTimer &timer, const std::string &name, const std::vector<std::string> &files, const std::vector<Vec3Dd> &control, unsigned int nbPlanes, bool isReordered){
+    const bool isFibula = name == "fibula";
+    CurveGeometry curve(control);
+    unsigned int nbU = 0;
+    curve.generateAdaptiveCatmull(0.01, isFibula ? 0.5 : 1.0, nbU);
+    const std::vector<CutPlane> planes = isFibula ? fibulaPlanes(curve, nbPlanes) : mandiblePlanes(curve, nbPlanes);
+    const Side side = isFibula ? Side::EXTERIOR : Side::INTERIOR;
+    ThreadPool &pool = ThreadPool::global();
+
+    for(unsigned int i=0; i<files.size(); i++){
+        MeshGeometry mesh;
+        if(!openQuietly(files[i], mesh.getVertices(), mesh.getTriangles())) return false;
+        std::cout << files[i] << " : " << mesh.getVertices().size() << " verticies, " << mesh.getTriangles().size() << " triangles" << std::endl;
+        timer.setNbTriangles(mesh.getTriangles().size());
+
+        {
+            std::vector<Vec3Df> v;
+            std::vector<Triangle> t;
+            timer.time(isPLY(files[i]) ? "openPLY" : "openOFF", name, 0, [&](){ openQuietly(files[i], v, t); });
+        }
+        if(isReordered) benchReorder(timer, name, mesh);
+
+        // init is timed on the mesh itself, copying it for each repetition would need twice the memory
+        timer.time("init", name, 0, [&](){
+            mesh.collectOneRings();
+            mesh.recomputeNormals();
+        });
+
+        benchCut(timer, name, mesh, planes, side, pool);
+        if(isFibula){
+            mesh.cut(planes, side, pool);
+            MeshGeometry::SegmentTransfer transfer;
+            timer.time("sendToMandible", name, nbPlanes, [&](){ mesh.exportSegments(transfer); });
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef STAGES_H
+#define STAGES_H
+
+#include "stagetimer.h"
+#include "Vec3D.h"
+#include <string>
+#include <vector>
+
+/*
+ * Times each step of the planning on the two bundled meshes, one at a time : loading, reordering them for locality
+ * (unless isReordered is false), the one rings and normals (with and without SSE), packing the meshes, the curves,
+ * then every cutting stage and the transfer of the fibula segments to the mandible for 2 to maxPlanes planes.
+ * Returns false if the meshes can't be found in dataDir.
+*/
+bool benchStages(StageTimer &timer, const std::string &dataDir, const std::vector<Vec3Dd> &mandibleControl, const std::vector<Vec3Dd> &fibulaControl, unsigned int maxPlanes, bool isReordered);
+
+/*
+ * The same stages on bigger versions of one of the meshes (made by meshgen, which keeps them where the original was),
+ * with nbPlanes planes, to see how the time and the memory grow with the number of triangles.
+ * name is "mandible" or "fibula", control the control points of its curve.
+*/
+bool benchScaling(StageTimer &timer, const std::string &name, const std::vector<std::string> &files, const std::vector<Vec3Dd> &control, unsigned int nbPlanes, bool isReordered);
+
+#endif // STAGES_H
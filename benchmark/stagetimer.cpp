@@ -0,0 +1,145 @@
+#include "stagetimer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// 0 where /proc isn't there
+static double residentMemoryMB(){
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    unsigned long long size = 0, resident = 0;
+    if(statm >> size >> resident) return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0*1024.0);
+#endif
+    return 0;
+}
+
+double StageResult::min() const{
+    return times.size()!=0 ? *std::min_element(times.begin(), times.end()) : 0;
+}
+
+double StageResult::median() const{
+    if(times.size()==0) return 0;
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    const size_t middle = sorted.size()/2;
+    if(sorted.size()%2==1) return sorted[middle];
+    return (sorted[middle-1] + sorted[middle]) / 2.0;
+}
+
+double StageResult::mean() const{
+    if(times.size()==0) return 0;
+    double sum = 0;
+    for(size_t i=0; i<times.size(); i++) sum += times[i];
+    return sum / times.size();
+}
+
+double StageResult::stddev() const{
+    if(times.size()<2) return 0;
+    const double m = mean();
+    double sum = 0;
+    for(size_t i=0; i<times.size(); i++) sum += (times[i]-m) * (times[i]-m);
+    return std::sqrt(sum / (times.size()-1));
+}
+
+void StageTimer::time(const std::string &stage, const std::string &mesh, unsigned int nbPlanes, const std::function<void()> &setup, const std::function<void()> &run, unsigned int nbItems){
+    StageResult result;
+    result.stage = stage;
+    result.mesh = mesh;
+    result.nbPlanes = nbPlanes;
+    result.nbTriangles = nbTriangles;
+    result.nbItems = nbItems;
+
+    for(unsigned int i=0; i<warmup+repetitions; i++){
+        setup();
+        Clock::time_point t0 = Clock::now();
+        const PerfSample counters = PerfCounters::measure(run);
+        const double t = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        if(i >= warmup){
+            result.times.push_back(t / nbItems);
+            result.counters += counters;
+        }
+    }
+    result.residentMB = residentMemoryMB();
+
+    results.push_back(result);
+}
+
+void StageTimer::printTable(std::ostream &out) const{
+    const bool isCounters = PerfCounters::isEnabled();
+    out << std::left << std::setw(26) << "stage" << std::setw(10) << "mesh" << std::right << std::setw(11) << "triangles" << std::setw(7) << "planes"
+        << std::setw(13) << "median (ms)" << std::setw(13) << "min (ms)" << std::setw(13) << "stddev (ms)" << std::setw(10) << "RSS (MB)";
+    if(isCounters) out << std::setw(7) << "IPC" << std::setw(10) << "LLC MPKI" << std::setw(13) << "branch MPKI";
+    out << std::endl;
+
+    out << std::fixed << std::setprecision(4);
+    for(size_t i=0; i<results.size(); i++){
+        const StageResult &r = results[i];
+        out << std::left << std::setw(26) << r.stage << std::setw(10) << r.mesh << std::right << std::setw(11) << r.nbTriangles << std::setw(7) << r.nbPlanes
+            << std::setw(13) << r.median() << std::setw(13) << r.min() << std::setw(13) << r.stddev() << std::setw(10) << std::setprecision(1) << r.residentMB << std::setprecision(4);
+        if(isCounters){
+            if(r.counters.isValid) out << std::setprecision(2) << std::setw(7) << r.counters.getIPC() << std::setw(10) << r.counters.getCacheMPKI() << std::setw(13) << r.counters.getBranchMPKI() << std::setprecision(4);
+            else out << std::setw(7) << "-" << std::setw(10) << "-" << std::setw(13) << "-";
+        }
+        out << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+// Plain strings only (stage and mesh names, the label), so only the quotes and backslashes are escaped
+static std::string quoted(const std::string &s){
+    std::string q = "\"";
+    for(size_t i=0; i<s.size(); i++){
+        if(s[i]=='"' || s[i]=='\\') q += '\\';
+        q += s[i];
+    }
+    return q + "\"";
+}
+
+void StageTimer::writeJSON(std::ostream &out, const std::string &label, const std::string &commit, unsigned int nbThreads) const{
+    out << std::setprecision(9);
+    out << "{" << std::endl;
+    out << "  \"label\": " << quoted(label) << "," << std::endl;
+    out << "  \"commit\": " << quoted(commit) << "," << std::endl;
+    out << "  \"threads\": " << nbThreads << "," << std::endl;
+    out << "  \"warmup\": " << warmup << "," << std::endl;
+    out << "  \"repetitions\": " << repetitions << "," << std::endl;
+    out << "  \"results\": [" << std::endl;
+
+    for(size_t i=0; i<results.size(); i++){
+        const StageResult &r = results[i];
+        out << "    {\"stage\": " << quoted(r.stage) << ", \"mesh\": " << quoted(r.mesh) << ", \"triangles\": " << r.nbTriangles << ", \"planes\": " << r.nbPlanes
+            << ", \"calls\": " << r.nbItems << ", \"resident_mb\": " << r.residentMB
+            << ", \"min_ms\": " << r.min() << ", \"median_ms\": " << r.median() << ", \"mean_ms\": " << r.mean() << ", \"stddev_ms\": " << r.stddev();
+        if(r.counters.isValid){     // per call
+            out << ", \"cycles\": " << r.perCall(r.counters.cycles) << ", \"instructions\": " << r.perCall(r.counters.instructions)
+                << ", \"llc_misses\": " << r.perCall(r.counters.cacheMisses) << ", \"branch_misses\": " << r.perCall(r.counters.branchMisses)
+                << ", \"ipc\": " << r.counters.getIPC() << ", \"llc_mpki\": " << r.counters.getCacheMPKI() << ", \"branch_mpki\": " << r.counters.getBranchMPKI();
+        }
+        out << ", \"times_ms\": [";
+        for(size_t j=0; j<r.times.size(); j++) out << (j!=0 ? ", " : "") << r.times[j];
+        out << "]}" << (i+1 < results.size() ? "," : "") << std::endl;
+    }
+
+    out << "  ]" << std::endl;
+    out << "}" << std::endl;
+}
+
+void StageTimer::writeCSV(std::ostream &out) const{
+    out << "stage,mesh,triangles,planes,median (ms),min (ms),mean (ms),stddev (ms),resident (MB),IPC,LLC MPKI,branch MPKI" << std::endl;
+    out << std::setprecision(9);
+    for(size_t i=0; i<results.size(); i++){
+        const StageResult &r = results[i];
+        out << r.stage << "," << r.mesh << "," << r.nbTriangles << "," << r.nbPlanes << ","
+            << r.median() << "," << r.min() << "," << r.mean() << "," << r.stddev() << "," << r.residentMB << ",";
+        if(r.counters.isValid) out << r.counters.getIPC() << "," << r.counters.getCacheMPKI() << "," << r.counters.getBranchMPKI();
+        else out << ",,";
+        out << std::endl;
+    }
+}
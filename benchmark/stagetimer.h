@@ -0,0 +1,57 @@
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+#include "perfcounters.h"
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// The timings of one stage, for one mesh and one number of planes
+struct StageResult{
+    std::string stage;
+    std::string mesh;       // empty when it doesn't depend on a mesh
+    unsigned int nbPlanes = 0;
+    unsigned long long nbTriangles = 0;     // of the mesh
+    unsigned int nbItems = 1;       // the calls made by each repetition (the times are per call)
+    std::vector<double> times;      // ms
+    double residentMB = 0;      // the memory used by the process once the stage has run
+    PerfSample counters;        // summed over the repetitions (only with PerfCounters enabled)
+
+    double min() const;
+    double median() const;
+    double mean() const;
+    double stddev() const;
+    double perCall(uint64_t count) const { return times.size()!=0 ? static_cast<double>(count) / (times.size() * nbItems) : 0; }
+};
+
+/*
+ * Runs setup then stage warmup + repetitions times, only stage is timed.
+ * setup puts back whatever the stage changes so each repetition does the same work.
+ * With PerfCounters enabled the repetitions are counted too (on the calling thread).
+*/
+class StageTimer
+{
+public:
+    StageTimer(unsigned int warmup, unsigned int repetitions) : warmup(warmup), repetitions(repetitions){}
+
+    void time(const std::string &stage, const std::string &mesh, unsigned int nbPlanes, const std::function<void()> &setup, const std::function<void()> &run, unsigned int nbItems = 1);
+    void time(const std::string &stage, const std::string &mesh, unsigned int nbPlanes, const std::function<void()> &run, unsigned int nbItems = 1){ time(stage, mesh, nbPlanes, [](){}, run, nbItems); }
+
+    void setNbTriangles(unsigned long long nbTriangles){ this->nbTriangles = nbTriangles; }     // saved with the next results
+    const std::vector<StageResult>& getResults() const { return results; }
+    unsigned int getWarmup() const { return warmup; }
+    unsigned int getRepetitions() const { return repetitions; }
+
+    void printTable(std::ostream &out) const;
+    void writeJSON(std::ostream &out, const std::string &label, const std::string &commit, unsigned int nbThreads) const;
+    void writeCSV(std::ostream &out) const;     // one line per result, to plot
+
+private:
+    unsigned int warmup;
+    unsigned int repetitions;
+    unsigned long long nbTriangles = 0;
+    std::vector<StageResult> results;
+};
+
+#endif // STAGETIMER_H
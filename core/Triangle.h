@@ -24,19 +24,21 @@
 
 #include <iostream>
 #include <cassert>
+#include <type_traits>
 #include <vector>
 
+// Just the 3 indicies (no vtable) : a vector of triangles is a flat index array, which can be copied with memcpy or given to GL as is
 class Triangle {
 public:
   inline Triangle(){}
   inline Triangle (unsigned int v0, unsigned int v1, unsigned int v2) { init (v0, v1, v2); }
   inline Triangle (unsigned int * vp) { init (vp[0], vp[1], vp[2]); }
-  inline Triangle (const Triangle & it) { init (it.v[0], it.v[1], it.v[2]);  }
-  inline virtual ~Triangle () {}
-  inline Triangle & operator= (const Triangle & it) { init (it.v[0], it.v[1], it.v[2]); return (*this); }
+  Triangle (const Triangle & it) = default;
+  Triangle & operator= (const Triangle & it) = default;
   inline bool operator== (const Triangle & t) const { return (v[0] == t.v[0] && v[1] == t.v[1] && v[2] == t.v[2]); }
 
   inline unsigned int getVertex (unsigned int i) const { return v[i]; }
+  inline const unsigned int * data () const { return v; }
   inline void setVertex (unsigned int i, unsigned int vertex) { v[i] = vertex; }
   inline bool contains (unsigned int vertex) const { return (v[0] == vertex || v[1] == vertex || v[2] == vertex); }
   
@@ -55,6 +57,8 @@ private:
   unsigned int v[3];
 };
 
+static_assert(sizeof(Triangle) == 3*sizeof(unsigned int) && std::is_trivially_copyable<Triangle>::value, "Triangle must stay a plain index triple");
+
 extern std::ostream & operator<< (std::ostream & output, const Triangle & t);
 
 // Some Emacs-Hints -- please don't remove:
@@ -25,12 +25,11 @@
 #include <cassert>
 #include <cstdlib>
 
-#define GLEW_STATIC 1
-#include <QtOpenGL>
 #include <float.h>
 
 #include <cmath>
 #include <iostream>
+#include <type_traits>
 
 template<typename T> class Vec3D;
 
@@ -38,11 +37,11 @@ template <class T> bool operator!= (const Vec3D<T> & p1, const Vec3D<T> & p2) {
     return (p1[0] != p2[0] || p1[1] != p2[1] || p1[2] != p2[2]);
 }
 
-template <class T> const Vec3D<T> operator* (const Vec3D<T> & p, float factor) {
+template <class T> const Vec3D<T> operator* (const Vec3D<T> & p, double factor) {
     return Vec3D<T> (p[0] * factor, p[1] * factor, p[2] * factor);
 }
 
-template <class T> const Vec3D<T> operator* (float factor, const Vec3D<T> & p) {
+template <class T> const Vec3D<T> operator* (double factor, const Vec3D<T> & p) {
     return Vec3D<T> (p[0] * factor, p[1] * factor, p[2] * factor);
 }
 
@@ -62,7 +61,7 @@ template <class T> const Vec3D<T> operator- (const Vec3D<T> & p) {
     return Vec3D<T> (-p[0], -p[1], -p[2]);
 }
 
-template <class T> const Vec3D<T> operator/ (const Vec3D<T> & p, float divisor) {
+template <class T> const Vec3D<T> operator/ (const Vec3D<T> & p, double divisor) {
     return Vec3D<T> (p[0]/divisor, p[1]/divisor, p[2]/divisor);
 }
 
@@ -93,9 +92,7 @@ public:
         p[1] = p1;
         p[2] = p2;
     };
-    inline Vec3D (const Vec3D & v) {
-        init (v[0], v[1], v[2]);
-    }
+    Vec3D (const Vec3D & v) = default;
     inline Vec3D (T* pp) {
         p[0] = pp[0];
         p[1] = pp[1];
@@ -110,12 +107,7 @@ public:
     inline const T& operator[] (int Index) const {
         return (p[Index]);
     };
-    inline Vec3D& operator= (const Vec3D & P) {
-        p[0] = P[0];
-        p[1] = P[1];
-        p[2] = P[2];
-        return (*this);
-    };
+    Vec3D& operator= (const Vec3D & P) = default;
     inline Vec3D& operator+= (const Vec3D & P) {
         p[0] += P[0];
         p[1] += P[1];
@@ -308,15 +300,7 @@ typedef Vec3D<float> Vec3Df;
 typedef Vec3D<double> Vec3Dd;
 typedef Vec3D<int> Vec3Di;
 
-inline void glVertex( Vec3Df const & p )
-{
-    glVertex3f( p[0] , p[1] , p[2] );
-}
-
-inline void glNormal( Vec3Df const & p )
-{
-    glNormal3f( p[0] , p[1] , p[2] );
-}
+static_assert(sizeof(Vec3Df) == 3*sizeof(float) && std::is_trivially_copyable<Vec3Df>::value, "a vector of Vec3Df must be a flat float array");
 // Some Emacs-Hints -- please don't remove:
 //
 //  Local Variables:
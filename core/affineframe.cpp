@@ -0,0 +1,43 @@
+#include "affineframe.h"
+
+AffineFrame::AffineFrame() : origin(0,0,0){
+    axes[0] = Vec3Dd(1,0,0);
+    axes[1] = Vec3Dd(0,1,0);
+    axes[2] = Vec3Dd(0,0,1);
+}
+
+AffineFrame::AffineFrame(const Vec3Dd &origin, const Vec3Dd &x, const Vec3Dd &y, const Vec3Dd &z) : origin(origin){
+    axes[0] = x;
+    axes[1] = y;
+    axes[2] = z;
+}
+
+// The axes are the columns of the quaternion's rotation matrix
+AffineFrame AffineFrame::fromQuaternion(const Vec3Dd &origin, double qx, double qy, double qz, double qw){
+    const double xx = 2.0*qx*qx, yy = 2.0*qy*qy, zz = 2.0*qz*qz;
+    const double xy = 2.0*qx*qy, xz = 2.0*qx*qz, yz = 2.0*qy*qz;
+    const double wx = 2.0*qw*qx, wy = 2.0*qw*qy, wz = 2.0*qw*qz;
+
+    return AffineFrame(origin,
+                       Vec3Dd(1.0 - yy - zz, xy + wz, xz - wy),
+                       Vec3Dd(xy - wz, 1.0 - xx - zz, yz + wx),
+                       Vec3Dd(xz + wy, yz - wx, 1.0 - xx - yy));
+}
+
+Vec3Dd AffineFrame::localVectorOf(const Vec3Dd &v) const{
+    return Vec3Dd(Vec3Dd::dotProduct(v, axes[0]), Vec3Dd::dotProduct(v, axes[1]), Vec3Dd::dotProduct(v, axes[2]));
+}
+
+Vec3Dd AffineFrame::worldVectorOf(const Vec3Dd &v) const{
+    return v[0]*axes[0] + v[1]*axes[1] + v[2]*axes[2];
+}
+
+bool AffineFrame::operator==(const AffineFrame &f) const{
+    for(int i=0; i<3; i++){
+        if(origin[i] != f.origin[i]) return false;
+        for(unsigned int j=0; j<3; j++){
+            if(axes[j][i] != f.axes[j][i]) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef AFFINEFRAME_H
+#define AFFINEFRAME_H
+
+#include "Vec3D.h"
+
+// A rigid frame : an origin and three orthonormal axes given in world coordinates
+class AffineFrame
+{
+public:
+    AffineFrame();      // the world frame
+    AffineFrame(const Vec3Dd &origin, const Vec3Dd &x, const Vec3Dd &y, const Vec3Dd &z);
+    static AffineFrame fromQuaternion(const Vec3Dd &origin, double qx, double qy, double qz, double qw);     // same convention as qglviewer::Quaternion (w last)
+
+    const Vec3Dd& getOrigin() const { return origin; }
+    const Vec3Dd& getAxis(unsigned int i) const { return axes[i]; }
+    void setOrigin(const Vec3Dd &origin){ this->origin = origin; }
+
+    Vec3Dd localCoordinatesOf(const Vec3Dd &p) const { return localVectorOf(p - origin); }
+    Vec3Dd worldCoordinatesOf(const Vec3Dd &p) const { return origin + worldVectorOf(p); }
+    Vec3Dd localVectorOf(const Vec3Dd &v) const;
+    Vec3Dd worldVectorOf(const Vec3Dd &v) const;
+
+    bool operator==(const AffineFrame &f) const;        // exact comparison
+    bool operator!=(const AffineFrame &f) const { return !(*this == f); }
+
+private:
+    Vec3Dd origin;
+    Vec3Dd axes[3];
+};
+
+#endif // AFFINEFRAME_H
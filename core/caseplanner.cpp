@@ -0,0 +1,140 @@
+#include "caseplanner.h"
+#include <utility>
+
+CasePlanner::CasePlanner(MeshGeometry mandible, const std::vector<Vec3Dd> &mandibleControl, MeshGeometry fibula, const std::vector<Vec3Dd> &fibulaControl)
+    : mandible(std::move(mandible)), fibula(std::move(fibula)), mandibleCurve(mandibleControl), fibulaCurve(fibulaControl)
+{
+    this->mandible.reorderForLocality();
+    this->fibula.reorderForLocality();
+    this->mandible.collectOneRings();
+    this->mandible.recomputeNormals();
+    this->fibula.collectOneRings();
+    this->fibula.recomputeNormals();
+
+    // The same sampling as the viewers
+    unsigned int nbU = 0;
+    mandibleCurve.generateAdaptiveCatmull(0.01, 1.0, nbU);
+    fibulaCurve.generateAdaptiveCatmull(0.01, 0.5, nbU);
+}
+
+PieceCountEvaluator::PlanSummary CasePlanner::plan(const PlanSpec &spec, ThreadPool &pool){
+    const unsigned int nbU = mandibleCurve.getNbU();
+    PieceCountEvaluator evaluator(mandibleCurve, 0, nbU-1, fibulaCurve, 0, fibula.getVertices(), spec.constraint, spec.securityMargin, spec.isOptimise);
+
+    std::vector<unsigned int> plan, fibulaPlan;
+    PieceCountEvaluator::PlanSummary s = evaluator.evaluatePlan(spec.nbPieces, pool, plan, fibulaPlan);
+
+    // The left and right planes first, then the ghost planes
+    std::vector<CutPlane> mandiblePlanes;
+    mandiblePlanes.push_back(curvePlane(mandibleCurve, plan.front(), planeSize));
+    mandiblePlanes.push_back(curvePlane(mandibleCurve, plan.back(), planeSize));
+    for(unsigned int i=1; i+1<plan.size(); i++) mandiblePlanes.push_back(curvePlane(mandibleCurve, plan[i], planeSize));
+
+    // Piece k goes from plan[k] to plan[k+1] in the mandible, and from fibulaPlan[2k] to fibulaPlan[2k+1] in the fibula
+    const unsigned int nbPieces = static_cast<unsigned int>(plan.size()) - 1;
+    mandibleFrames.clear();
+    fibulaFrames.clear();
+    std::vector<CutPlane> pieceEnds;
+    for(unsigned int k=0; k<nbPieces; k++){
+        mandibleFrames.push_back(pieceFrame(mandibleCurve, plan[k], plan[k+1]));
+        fibulaFrames.push_back(pieceFrame(fibulaCurve, fibulaPlan[2*k], fibulaPlan[2*k+1]));
+
+        const double startSize = k==0 ? planeSize : ghostPlaneSize;
+        const double endSize = k==nbPieces-1 ? planeSize : ghostPlaneSize;
+        pieceEnds.push_back(movePlane(curvePlane(mandibleCurve, plan[k], planeSize), mandibleFrames[k], fibulaFrames[k], startSize));
+        pieceEnds.push_back(movePlane(curvePlane(mandibleCurve, plan[k+1], planeSize), mandibleFrames[k], fibulaFrames[k], endSize));
+    }
+
+    std::vector<CutPlane> fibulaPlanes;
+    fibulaPlanes.push_back(pieceEnds.front());
+    fibulaPlanes.push_back(pieceEnds.back());
+    fibulaPlanes.insert(fibulaPlanes.end(), pieceEnds.begin()+1, pieceEnds.end()-1);
+
+    mandible.cut(mandiblePlanes, Side::INTERIOR, pool);
+    fibula.cut(fibulaPlanes, Side::EXTERIOR, pool);
+
+    return s;
+}
+
+CutPlane CasePlanner::curvePlane(const CurveGeometry &curve, unsigned int index, double size){
+    const Vec3Dd t = curve.tangent(index);
+    const Vec3Dd &n = curve.getFrameNormal(index);
+    return CutPlane(AffineFrame(curve.getPoint(index), n, Vec3Dd::crossProduct(t, n), t), size);
+}
+
+AffineFrame CasePlanner::pieceFrame(const CurveGeometry &curve, unsigned int a, unsigned int b){
+    Vec3Dd z = curve.getPoint(b) - curve.getPoint(a);
+    if(z.norm() == 0) z = curve.tangent(a);     // the piece ran off the end of the curve
+    z.normalize();
+
+    Vec3Dd x = curve.getFrameNormal(a);
+    x -= Vec3Dd::dotProduct(x, z) * z;
+    x.normalize();
+
+    return AffineFrame(curve.getPoint(a), x, Vec3Dd::crossProduct(z, x), z);
+}
+
+CutPlane CasePlanner::movePlane(const CutPlane &p, const AffineFrame &from, const AffineFrame &to, double size){
+    const AffineFrame &f = p.getFrame();
+    Vec3Dd axes[3];
+    for(unsigned int i=0; i<3; i++) axes[i] = to.worldVectorOf(from.localVectorOf(f.getAxis(i)));
+    return CutPlane(AffineFrame(to.worldCoordinatesOf(from.localCoordinatesOf(f.getOrigin())), axes[0], axes[1], axes[2]), size);
+}
+
+void CasePlanner::extract(const MeshGeometry &mesh, const std::vector<unsigned int> &triangleIndexes, std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles){
+    const std::vector<Vec3Df> &smoothed = mesh.getSmoothedVertices();
+    std::vector<int> newIndex(smoothed.size(), -1);
+
+    vertices.clear();
+    triangles.clear();
+    for(unsigned int i=0; i<triangleIndexes.size(); i++){
+        const Triangle &t = mesh.getTriangles()[triangleIndexes[i]];
+        unsigned int v[3];
+        for(unsigned int j=0; j<3; j++){
+            const unsigned int index = t.getVertex(j);
+            if(newIndex[index] == -1){
+                newIndex[index] = static_cast<int>(vertices.size());
+                vertices.push_back(smoothed[index]);
+            }
+            v[j] = static_cast<unsigned int>(newIndex[index]);
+        }
+        triangles.push_back(Triangle(v[0], v[1], v[2]));
+    }
+}
+
+void CasePlanner::reportMemory(MemoryReport &report) const{
+    MemoryReport mandibleReport, mandibleCurveReport, fibulaReport, fibulaCurveReport;
+    mandible.reportMemory(mandibleReport);
+    mandibleCurve.reportMemory(mandibleCurveReport);
+    fibula.reportMemory(fibulaReport);
+    fibulaCurve.reportMemory(fibulaCurveReport);
+
+    report.add("mandible.", mandibleReport);
+    report.add("mandible.curve.", mandibleCurveReport);
+    report.add("fibula.", fibulaReport);
+    report.add("fibula.curve.", fibulaCurveReport);
+}
+
+void CasePlanner::getMandibleCut(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles) const{
+    extract(mandible, mandible.getTrianglesCut(), vertices, triangles);
+}
+
+void CasePlanner::getSegment(unsigned int k, std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles) const{
+    // The segments are coloured in order along the fibula, starting from the left plane
+    std::vector<int> colours;
+    fibula.fillColours(colours, fibulaFrames.size()*4);
+
+    std::vector<unsigned int> segment;
+    const std::vector<unsigned int> &trianglesCut = fibula.getTrianglesCut();
+    for(unsigned int i=0; i<trianglesCut.size(); i++){
+        if(colours[fibula.getTriangles()[trianglesCut[i]].getVertex(0)] == static_cast<int>(k)) segment.push_back(trianglesCut[i]);
+    }
+
+    extract(fibula, segment, vertices, triangles);
+
+    for(unsigned int i=0; i<vertices.size(); i++){
+        const Vec3Dd p(vertices[i][0], vertices[i][1], vertices[i][2]);
+        const Vec3Dd moved = mandibleFrames[k].worldCoordinatesOf(fibulaFrames[k].localCoordinatesOf(p));
+        vertices[i] = Vec3Df(static_cast<float>(moved[0]), static_cast<float>(moved[1]), static_cast<float>(moved[2]));
+    }
+}
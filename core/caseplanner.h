@@ -0,0 +1,53 @@
+#ifndef CASEPLANNER_H
+#define CASEPLANNER_H
+
+#include "meshgeometry.h"
+#include "curvegeometry.h"
+#include "piececountevaluator.h"
+
+/*
+ * Plans and cuts one case without the viewers, with the same steps : the ghost planes are placed in the mandible,
+ * the pieces are laid out along the fibula, then both meshes are cut.
+ * Each fibula piece is a rigid copy of the mandible between two of its planes : the chords of the two curves are lined up,
+ * then their normals. The fibula planes are the mandible planes moved the same way.
+*/
+class CasePlanner
+{
+public:
+    struct PlanSpec{
+        unsigned int nbPieces = 3;
+        bool isOptimise = false;
+        double constraint = 25.0;       // the shortest piece (mm)
+        double securityMargin = 30.0;   // the bone left between two pieces on the fibula (mm)
+    };
+
+    CasePlanner(MeshGeometry mandible, const std::vector<Vec3Dd> &mandibleControl, MeshGeometry fibula, const std::vector<Vec3Dd> &fibulaControl);
+
+    PieceCountEvaluator::PlanSummary plan(const PlanSpec &spec, ThreadPool &pool);
+
+    const MeshGeometry& getMandible() const { return mandible; }
+    const MeshGeometry& getFibula() const { return fibula; }
+    unsigned int getNbSegments() const { return static_cast<unsigned int>(fibula.getSegmentsConserved().size()); }     // fewer than the pieces when two pieces' planes cross inside the fibula
+    void getMandibleCut(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles) const;     // what's left of the mandible
+    void getSegment(unsigned int k, std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles) const;       // fibula piece k, moved into the mandible
+    void reportMemory(MemoryReport &report) const;      // both meshes and curves
+
+private:
+    static CutPlane curvePlane(const CurveGeometry &curve, unsigned int index, double size);        // the plane follows the rotation minimising frame
+    static AffineFrame pieceFrame(const CurveGeometry &curve, unsigned int a, unsigned int b);     // origin at a, z along the chord [a,b]
+    static CutPlane movePlane(const CutPlane &p, const AffineFrame &from, const AffineFrame &to, double size);
+    static void extract(const MeshGeometry &mesh, const std::vector<unsigned int> &triangleIndexes, std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles);     // only the verticies used by these triangles
+
+    MeshGeometry mandible;
+    MeshGeometry fibula;
+    CurveGeometry mandibleCurve;
+    CurveGeometry fibulaCurve;
+
+    std::vector<AffineFrame> mandibleFrames;        // one per piece
+    std::vector<AffineFrame> fibulaFrames;
+
+    const double planeSize = 40.0;          // the end planes and the mandible planes
+    const double ghostPlaneSize = 25.0;     // the ghost planes in the fibula
+};
+
+#endif // CASEPLANNER_H
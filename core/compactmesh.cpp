@@ -0,0 +1,113 @@
+#include "compactmesh.h"
+#include "vec3kernels.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+static const float quantisationSteps = 65535.f;
+
+CompactMesh::CompactMesh(const std::vector<Vec3Df> &vertices, const std::vector<Vec3Df> &normals, const std::vector<Triangle> &triangles, bool isQuantised){
+    nbVertices = static_cast<unsigned int>(vertices.size());
+    this->isQuantised = isQuantised;
+
+    indices.resize(3*triangles.size());
+    if(triangles.size()!=0) std::memcpy(indices.data(), triangles.data(), indices.size() * sizeof(uint32_t));
+
+    if(isQuantised){
+        Vec3Df bbMax;
+        Vec3Kernels::boundingBox(vertices, bbMin, bbMax);
+        for(int k=0; k<3; k++) bbStep[k] = bbMax[k] > bbMin[k] ? (bbMax[k] - bbMin[k]) / quantisationSteps : 1.f;
+
+        qx.resize(nbVertices);
+        qy.resize(nbVertices);
+        qz.resize(nbVertices);
+        for(unsigned int i=0; i<nbVertices; i++){
+            qx[i] = static_cast<uint16_t>(std::lround(std::min(quantisationSteps, (vertices[i][0] - bbMin[0]) / bbStep[0])));
+            qy[i] = static_cast<uint16_t>(std::lround(std::min(quantisationSteps, (vertices[i][1] - bbMin[1]) / bbStep[1])));
+            qz[i] = static_cast<uint16_t>(std::lround(std::min(quantisationSteps, (vertices[i][2] - bbMin[2]) / bbStep[2])));
+        }
+    }
+    else{
+        x.resize(nbVertices);
+        y.resize(nbVertices);
+        z.resize(nbVertices);
+        for(unsigned int i=0; i<nbVertices; i++){
+            x[i] = vertices[i][0];
+            y[i] = vertices[i][1];
+            z[i] = vertices[i][2];
+        }
+    }
+
+    this->normals.resize(normals.size());
+    for(unsigned int i=0; i<normals.size(); i++) this->normals[i] = octEncode(normals[i]);
+}
+
+void CompactMesh::unpack(std::vector<Vec3Df> &vertices, std::vector<Vec3Df> &normals, std::vector<Triangle> &triangles) const{
+    vertices.resize(nbVertices);
+    for(unsigned int i=0; i<nbVertices; i++) vertices[i] = getPosition(i);
+
+    normals.resize(this->normals.size());
+    for(unsigned int i=0; i<this->normals.size(); i++) normals[i] = octDecode(this->normals[i]);
+
+    triangles.resize(getNbTriangles());
+    if(indices.size()!=0) std::memcpy(static_cast<void*>(triangles.data()), indices.data(), indices.size() * sizeof(uint32_t));
+}
+
+Vec3Df CompactMesh::getPosition(unsigned int i) const{
+    if(isQuantised) return Vec3Df(bbMin[0] + qx[i] * bbStep[0], bbMin[1] + qy[i] * bbStep[1], bbMin[2] + qz[i] * bbStep[2]);
+    return Vec3Df(x[i], y[i], z[i]);
+}
+
+// Half a step on every axis, and the float rounding of (position - bbMin) / bbStep and bbMin + q * bbStep (a few ulps of the coordinates)
+float CompactMesh::getMaxPositionError() const{
+    if(!isQuantised) return 0;
+    double squared = 0;
+    for(int k=0; k<3; k++){
+        const double bbMax = static_cast<double>(bbMin[k]) + quantisationSteps * static_cast<double>(bbStep[k]);
+        const double axis = 0.5 * bbStep[k] + 4.0 * FLT_EPSILON * (std::abs(static_cast<double>(bbMin[k])) + std::abs(bbMax));
+        squared += axis * axis;
+    }
+    return static_cast<float>(std::sqrt(squared));
+}
+
+void CompactMesh::reportMemory(MemoryReport &report) const{
+    report.add("indices", indices);
+    report.add("x", x);
+    report.add("y", y);
+    report.add("z", z);
+    report.add("qx", qx);
+    report.add("qy", qy);
+    report.add("qz", qz);
+    report.add("normals", normals);
+}
+
+// The unit sphere is projected on the octahedron |x|+|y|+|z| = 1, whose lower half is folded over the upper one
+uint32_t CompactMesh::octEncode(const Vec3Df &n){
+    const float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    float u = l1 > 0 ? n[0] / l1 : 0;
+    float v = l1 > 0 ? n[1] / l1 : 0;
+    if(n[2] < 0){
+        const float fu = (1.f - std::abs(v)) * (u >= 0 ? 1.f : -1.f);
+        const float fv = (1.f - std::abs(u)) * (v >= 0 ? 1.f : -1.f);
+        u = fu;
+        v = fv;
+    }
+
+    const uint32_t qu = static_cast<uint32_t>(std::lround((std::max(-1.f, std::min(1.f, u)) * 0.5f + 0.5f) * quantisationSteps));
+    const uint32_t qv = static_cast<uint32_t>(std::lround((std::max(-1.f, std::min(1.f, v)) * 0.5f + 0.5f) * quantisationSteps));
+    return qu | (qv << 16);
+}
+
+Vec3Df CompactMesh::octDecode(uint32_t code){
+    const float u = static_cast<float>(code & 0xffff) / quantisationSteps * 2.f - 1.f;
+    const float v = static_cast<float>(code >> 16) / quantisationSteps * 2.f - 1.f;
+
+    Vec3Df n(u, v, 1.f - std::abs(u) - std::abs(v));
+    if(n[2] < 0){
+        n[0] = (1.f - std::abs(v)) * (u >= 0 ? 1.f : -1.f);
+        n[1] = (1.f - std::abs(u)) * (v >= 0 ? 1.f : -1.f);
+    }
+    n.normalize();
+    return n;
+}
@@ -0,0 +1,51 @@
+#ifndef COMPACTMESH_H
+#define COMPACTMESH_H
+
+#include "Vec3D.h"
+#include "Triangle.h"
+#include "memoryreport.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * A mesh packed to be kept or sent around : flat uint32 indicies, the positions as 3 float arrays (or as 16 bit steps
+ * across the bounding box) and the normals octahedron-encoded on 2x16 bits.
+ * The cutting stages still work on MeshGeometry, which is unpacked from this in one pass.
+*/
+class CompactMesh
+{
+public:
+    CompactMesh(){}
+    CompactMesh(const std::vector<Vec3Df> &vertices, const std::vector<Vec3Df> &normals, const std::vector<Triangle> &triangles, bool isQuantised);
+
+    void unpack(std::vector<Vec3Df> &vertices, std::vector<Vec3Df> &normals, std::vector<Triangle> &triangles) const;
+
+    unsigned int getNbVertices() const { return nbVertices; }
+    unsigned int getNbTriangles() const { return static_cast<unsigned int>(indices.size() / 3); }
+    const std::vector<uint32_t>& getIndices() const { return indices; }
+    bool getIsQuantised() const { return isQuantised; }
+    bool hasNormals() const { return normals.size() != 0; }
+
+    Vec3Df getPosition(unsigned int i) const;
+    Vec3Df getNormal(unsigned int i) const { return octDecode(normals[i]); }
+    float getMaxPositionError() const;      // how far a quantised position can be from the original (0 if not quantised)
+
+    void reportMemory(MemoryReport &report) const;
+
+    static uint32_t octEncode(const Vec3Df &n);     // n must be normalised
+    static Vec3Df octDecode(uint32_t code);
+
+private:
+    unsigned int nbVertices = 0;
+    std::vector<uint32_t> indices;
+
+    bool isQuantised = false;
+    std::vector<float> x, y, z;
+    std::vector<uint16_t> qx, qy, qz;       // (position - bbMin) / bbStep, rounded
+    Vec3Df bbMin;
+    Vec3Df bbStep;
+
+    std::vector<uint32_t> normals;
+};
+
+#endif // COMPACTMESH_H
@@ -0,0 +1,25 @@
+# Links a project against the medmax_core library (built by core.pro)
+
+INCLUDEPATH *= $$PWD
+DEPENDPATH  *= $$PWD
+
+tracing: DEFINES *= MEDMAX_TRACING
+memtrack: DEFINES *= MEDMAX_MEMORY_TRACKING
+
+CORE_BUILD_DIR = $$OUT_PWD/../core
+
+win32 {
+	CONFIG(debug, debug|release) {
+		CORE_BUILD_DIR = $${CORE_BUILD_DIR}/debug
+	} else {
+		CORE_BUILD_DIR = $${CORE_BUILD_DIR}/release
+	}
+	LIBS += -L$${CORE_BUILD_DIR} -lmedmax_core
+	win32-g++: PRE_TARGETDEPS += $${CORE_BUILD_DIR}/libmedmax_core.a
+	else: PRE_TARGETDEPS += $${CORE_BUILD_DIR}/medmax_core.lib
+} else {
+	LIBS += -L$${CORE_BUILD_DIR} -lmedmax_core
+	PRE_TARGETDEPS += $${CORE_BUILD_DIR}/libmedmax_core.a
+}
+
+LIBS += -lpthread
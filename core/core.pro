@@ -0,0 +1,59 @@
+# The planning engine without Qt or OpenGL : meshes, cutting planes, curves and the cutting stages.
+# The viewers and the benchmarks link against it, it can also be used on its own (batch runs, tests).
+
+TEMPLATE = lib
+TARGET   = medmax_core
+
+CONFIG += staticlib warn_on thread c++14
+CONFIG -= qt app_bundle
+
+# qmake CONFIG+=tracing compiles the MEDMAX_TRACE timers in (see trace.h)
+tracing: DEFINES *= MEDMAX_TRACING
+# qmake CONFIG+=memtrack counts every allocation to give the peak (see memoryreport.h)
+memtrack: DEFINES *= MEDMAX_MEMORY_TRACKING
+
+HEADERS  = \
+    affineframe.h \
+    caseplanner.h \
+    compactmesh.h \
+    curvegeometry.h \
+    cutcache.h \
+    cutplane.h \
+    fibulaplanning.h \
+    memoryreport.h \
+    meshgeometry.h \
+    meshreader.h \
+    meshreorder.h \
+    perfcounters.h \
+    piececountevaluator.h \
+    planoptimizer.h \
+    slabindex.h \
+    taskgraph.h \
+    threadpool.h \
+    trace.h \
+    Triangle.h \
+    varint.h \
+    Vec3D.h \
+    vec3kernels.h
+SOURCES  = \
+    affineframe.cpp \
+    caseplanner.cpp \
+    compactmesh.cpp \
+    curvegeometry.cpp \
+    cutcache.cpp \
+    cutplane.cpp \
+    memoryreport.cpp \
+    meshgeometry.cpp \
+    meshreorder.cpp \
+    perfcounters.cpp \
+    piececountevaluator.cpp \
+    planoptimizer.cpp \
+    slabindex.cpp \
+    taskgraph.cpp \
+    threadpool.cpp \
+    trace.cpp \
+    vec3kernels.cpp
+
+unix {
+	OBJECTS_DIR = .obj
+}
@@ -0,0 +1,559 @@
+#include "curvegeometry.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+static double dot(const Vec3Dd &a, const Vec3Dd &b){ return Vec3Dd::dotProduct(a, b); }
+static Vec3Dd cross(const Vec3Dd &a, const Vec3Dd &b){ return Vec3Dd::crossProduct(a, b); }
+
+// Any vector orthogonal to v (the same choice as qglviewer::Vec::orthogonalVec)
+static Vec3Dd orthogonalVec(const Vec3Dd &v){
+    if(fabs(v[1]) >= 0.9*fabs(v[0]) && fabs(v[2]) >= 0.9*fabs(v[0])) return Vec3Dd(0.0, -v[2], v[1]);
+    else if(fabs(v[0]) >= 0.9*fabs(v[1]) && fabs(v[2]) >= 0.9*fabs(v[1])) return Vec3Dd(-v[2], 0.0, v[0]);
+    return Vec3Dd(-v[1], v[0], 0.0);
+}
+
+CurveGeometry::CurveGeometry(const std::vector<Vec3Dd> &controlPoints) : controlPoints(controlPoints){
+    this->nbU = 0;
+    this->degree = 3;
+    this->knotIndex = 0;
+    this->arcLengthSlack = 0;
+}
+
+void CurveGeometry::generateBSpline(unsigned int& nbU, unsigned int degree){
+    this->nbU = nbU;
+    this->degree = degree;
+    this->knotIndex = 0;
+    isBSpline = true;
+
+    generateUniformKnotVector(0, this->knotVector);
+    bspline();
+
+    computeArcLengths();
+    computeFrames();
+}
+
+void CurveGeometry::generateCatmull(unsigned int& n){
+    const unsigned int nbControlPoint = getNbControlPoints();
+    unsigned int nbSeg = nbControlPoint-3;
+
+    this->nbU = n - n%nbSeg;
+    n = nbU;    // update the nbU in viewer
+    this->knotIndex = 0;
+    this->degree = 3;
+    isBSpline = false;
+
+    generateCatmullKnotVector(0.3, this->knotVector);
+
+    // The same number of samples for each segment, evenly spaced in the parameter
+    unsigned int uPerSeg = nbU/nbSeg;
+    sampleParams.resize(nbU);
+    segmentSamples.resize(nbSeg+1);
+    for(unsigned int j=1; j<=nbSeg; j++){
+        segmentSamples[j-1] = (j-1)*uPerSeg;
+        double step = (knotVector[j+1]-knotVector[j]) / static_cast<double>(uPerSeg);
+        for(unsigned int it=0; it<uPerSeg; it++) sampleParams[(j-1)*uPerSeg+it] = knotVector[j] + step*static_cast<double>(it);
+    }
+    segmentSamples[nbSeg] = nbU;
+
+    catmullrom();
+    computeArcLengths();
+    computeFrames();
+}
+
+void CurveGeometry::generateAdaptiveCatmull(double chordError, double maxSpacing, unsigned int& n){
+    const unsigned int nbControlPoint = getNbControlPoints();
+    unsigned int nbSeg = nbControlPoint-3;
+
+    this->knotIndex = 0;
+    this->degree = 3;
+    isBSpline = false;
+
+    generateCatmullKnotVector(0.3, this->knotVector);
+
+    sampleParams.clear();
+    segmentSamples.resize(nbSeg+1);
+    for(unsigned int j=1; j<=nbSeg; j++){
+        segmentSamples[j-1] = static_cast<unsigned int>(sampleParams.size());
+        knotIndex = j;
+
+        Vec3Dd pa, pb, d1, d2;
+        calculateCatmullPoints(pa, d1, d2, knotVector[j]);
+        calculateCatmullPoints(pb, d1, d2, knotVector[j+1]);
+
+        sampleParams.push_back(knotVector[j]);
+        subdivideSegment(knotVector[j], pa, knotVector[j+1], pb, chordError, maxSpacing, 0);
+    }
+    sampleParams.push_back(knotVector[nbSeg+1]);        // the end of the last segment
+    segmentSamples[nbSeg] = static_cast<unsigned int>(sampleParams.size());
+
+    this->nbU = static_cast<unsigned int>(sampleParams.size());
+    n = nbU;
+
+    catmullrom();
+    computeArcLengths();
+    computeFrames();
+}
+
+// Adds the parameters strictly between a and b (in order) until every chord is close enough to the curve
+void CurveGeometry::subdivideSegment(double a, const Vec3Dd &pa, double b, const Vec3Dd &pb, double chordError, double maxSpacing, unsigned int depth){
+    const unsigned int minDepth = 1;        // split at least once so an S shaped piece can't hide between the ends
+    const unsigned int maxDepth = 16;
+
+    double m = (a+b) / 2.0;
+    Vec3Dd pm, d1, d2;
+    calculateCatmullPoints(pm, d1, d2, m);
+
+    // Distance from the middle of the piece of curve to the chord
+    Vec3Dd chord = pb - pa;
+    double chordLength = chord.norm();
+    double error;
+    if(chordLength > 0) error = cross(pm - pa, chord).norm() / chordLength;
+    else error = (pm - pa).norm();
+
+    if(depth >= maxDepth) return;
+    if(depth >= minDepth && error <= chordError && chordLength <= maxSpacing) return;
+
+    subdivideSegment(a, pa, m, pm, chordError, maxSpacing, depth+1);
+    sampleParams.push_back(m);
+    subdivideSegment(m, pm, b, pb, chordError, maxSpacing, depth+1);
+}
+
+unsigned int CurveGeometry::indexAtLength(double length) const{
+    if(length <= 0) return 0;
+    if(length >= getTotalLength()) return nbU-1;
+
+    unsigned int k = static_cast<unsigned int>(std::lower_bound(arcLength.begin(), arcLength.end(), length) - arcLength.begin());
+    if(k > 0 && length - arcLength[k-1] < arcLength[k] - length) return k-1;
+    return k;
+}
+
+void CurveGeometry::generateUniformKnotVector(unsigned int a, std::vector<double>& kv){
+    unsigned int k = degree - a;
+    unsigned int n = getNbControlPoints() - a;
+    unsigned int m = n + k + 1;
+
+    kv.resize(static_cast<unsigned long long>(m));
+
+    double denom = static_cast<double>(m) - 2.0* static_cast<double>(k) - 1.0;
+
+    for(unsigned int i=0; i<=k; i++) kv[i] = 0;
+    for(unsigned int i=k+1; i<m-k-1; i++) kv[i] = static_cast<double>(i-k) / denom;
+    for(unsigned int i=m-k-1; i<m; i++) kv[i] = 1.0;
+}
+
+// All the non zero derivatives of the degree+1 basis functions of the span at u (Piegl & Tiller, The NURBS Book, A2.3)
+static void basisDerivatives(const std::vector<double> &kv, unsigned int span, double u, unsigned int degree, std::vector<double> &ders){
+    const unsigned int p = degree;
+    const unsigned int n = p+1;
+    std::vector<double> ndu(n*n), left(n), right(n), a(2*n);
+
+    ndu[0] = 1.0;
+    for(unsigned int j=1; j<=p; j++){
+        left[j] = u - kv[span+1-j];
+        right[j] = kv[span+j] - u;
+        double saved = 0.0;
+        for(unsigned int r=0; r<j; r++){
+            ndu[j*n+r] = right[r+1] + left[j-r];        // lower triangle : knot differences
+            double temp = ndu[r*n+j-1] / ndu[j*n+r];
+            ndu[r*n+j] = saved + right[r+1]*temp;       // upper triangle : basis functions
+            saved = left[j-r]*temp;
+        }
+        ndu[j*n+j] = saved;
+    }
+
+    ders.assign(n*n, 0.0);      // ders[k*n+j] : kth derivative of the jth function
+    for(unsigned int j=0; j<=p; j++) ders[j] = ndu[j*n+p];
+
+    for(unsigned int r=0; r<=p; r++){
+        double *a0 = &a[0];
+        double *a1 = &a[n];
+        a0[0] = 1.0;
+        for(unsigned int k=1; k<=p; k++){
+            double d = 0.0;
+            int rk = static_cast<int>(r) - static_cast<int>(k);
+            unsigned int pk = p-k;
+            if(r >= k){
+                a1[0] = a0[0] / ndu[(pk+1)*n+static_cast<unsigned int>(rk)];
+                d = a1[0] * ndu[static_cast<unsigned int>(rk)*n+pk];
+            }
+            unsigned int j1 = (rk >= -1) ? 1 : static_cast<unsigned int>(-rk);
+            unsigned int j2 = (static_cast<int>(r)-1 <= static_cast<int>(pk)) ? k-1 : p-r;
+            for(unsigned int j=j1; j<=j2; j++){
+                a1[j] = (a0[j] - a0[j-1]) / ndu[(pk+1)*n+static_cast<unsigned int>(rk)+j];
+                d += a1[j] * ndu[(static_cast<unsigned int>(rk)+j)*n+pk];
+            }
+            if(r <= pk){
+                a1[k] = -a0[k-1] / ndu[(pk+1)*n+r];
+                d += a1[k] * ndu[r*n+pk];
+            }
+            ders[k*n+r] = d;
+            std::swap(a0, a1);
+        }
+    }
+
+    double factor = p;
+    for(unsigned int k=1; k<=p; k++){
+        for(unsigned int j=0; j<=p; j++) ders[k*n+j] *= factor;
+        factor *= static_cast<double>(p-k);
+    }
+}
+
+// The Taylor expansion of the basis functions at the start of each span, and which samples fall in which span
+void CurveGeometry::computeSpanBases(){
+    if(basisKnots == knotVector && basisDegree == degree && basisNbU == nbU) return;
+
+    const unsigned int p = degree;
+    const unsigned int n = p+1;
+    std::vector<double> ders;
+
+    spans.clear();
+    spanSamples.clear();
+    spanBases.clear();
+    sampleOffsets.resize(nbU);
+
+    unsigned int span = p;
+    for(unsigned int i=0; i<nbU; i++){
+        double u = (1.0 / static_cast<double>(nbU-1)) * static_cast<double>(i);
+        while(u >= knotVector[span+1] && span+1 < getNbControlPoints()) span++;     // the last sample (u=1) stays in the last span
+
+        if(spans.size()==0 || spans.back() != span){
+            spans.push_back(span);
+            spanSamples.push_back(i);
+
+            basisDerivatives(knotVector, span, knotVector[span], p, ders);
+            double factorial = 1.0;
+            for(unsigned int k=0; k<=p; k++){
+                if(k > 1) factorial *= static_cast<double>(k);
+                for(unsigned int j=0; j<=p; j++) spanBases.push_back(ders[k*n+j] / factorial);
+            }
+        }
+
+        sampleOffsets[i] = u - knotVector[span];
+    }
+    spanSamples.push_back(nbU);
+
+    basisKnots = knotVector;
+    basisDegree = degree;
+    basisNbU = nbU;
+}
+
+void CurveGeometry::bspline(){
+    computeSpanBases();
+
+    const unsigned int p = degree;
+    const unsigned int n = p+1;
+
+    curve.resize(nbU);
+    dt.resize(nbU);
+    d2t.resize(nbU);
+
+    std::vector<double> coefficients(n);
+    std::vector<double> result[3][3];       // [derivative][x,y,z]
+    for(unsigned int d=0; d<3; d++){
+        for(unsigned int c=0; c<3; c++) result[d][c].resize(nbU);
+    }
+
+    const double *x = &sampleOffsets[0];
+    for(unsigned int s=0; s<spans.size(); s++){
+        const double *basis = &spanBases[s*n*n];
+        const unsigned int start = spanSamples[s];
+        const unsigned int end = spanSamples[s+1];
+
+        for(unsigned int c=0; c<3; c++){
+            for(unsigned int k=0; k<=p; k++){
+                coefficients[k] = 0;
+                for(unsigned int j=0; j<=p; j++) coefficients[k] += basis[k*n+j] * controlPoints[spans[s]-p+j][static_cast<int>(c)];
+            }
+
+            // Horner's scheme for the value and the two derivatives, the samples of a span share the coefficients so the inner loops vectorise
+            double *v = &result[0][c][0];
+            double *d1 = &result[1][c][0];
+            double *d2 = &result[2][c][0];
+            for(unsigned int i=start; i<end; i++){
+                v[i] = coefficients[p];
+                d1[i] = 0;
+                d2[i] = 0;
+            }
+            for(unsigned int k=p; k-- > 0;){
+                const double a = coefficients[k];
+                for(unsigned int i=start; i<end; i++){
+                    d2[i] = d2[i]*x[i] + d1[i];
+                    d1[i] = d1[i]*x[i] + v[i];
+                    v[i] = v[i]*x[i] + a;
+                }
+            }
+        }
+    }
+
+    for(unsigned int i=0; i<nbU; i++){
+        curve[i] = Vec3Dd(result[0][0][i], result[0][1][i], result[0][2][i]);
+        dt[i] = Vec3Dd(result[1][0][i], result[1][1][i], result[1][2][i]);
+        d2t[i] = 2.0 * Vec3Dd(result[2][0][i], result[2][1][i], result[2][2][i]);
+    }
+}
+
+void CurveGeometry::regenerate(){
+    if(isBSpline) bspline();
+    else catmullrom();
+    computeArcLengths();
+    computeFrames();
+}
+
+unsigned int CurveGeometry::controlPointMoved(unsigned int index){
+    if(isBSpline){      // the bases are kept, so this is only a few multiplications per sample
+        regenerate();
+        return 0;
+    }
+
+    const unsigned int nbSeg = getNbControlPoints()-3;
+
+    // Segment j is defined by the control points j-1 to j+2
+    const unsigned int first = index < 3 ? 1 : index-2;
+    const unsigned int last = std::min(index+1, nbSeg);
+    if(first > last) return nbU;
+
+    catmullromSegments(first, last);
+
+    // The frames are carried along the curve, so every frame after the first new sample turns
+    const unsigned int start = segmentSamples[first-1];
+    computeArcLengths(start);
+    computeFrames(start);
+
+    return start;
+}
+
+void CurveGeometry::generateCatmullKnotVector(double alpha, std::vector<double>& kv){
+    const unsigned int nbControlPoint = getNbControlPoints();
+    kv.resize(static_cast<unsigned long long>(nbControlPoint));
+
+    kv[0] = 0;
+
+    for(unsigned int i=1; i<nbControlPoint; i++){
+        Vec3Dd p = controlPoints[i] - controlPoints[i-1];
+        kv[i] =  pow(p.norm(),alpha) + kv[i-1];
+    }
+}
+
+// Catmull rom
+void CurveGeometry::calculateCatmullPoints(Vec3Dd& c, Vec3Dd& cp, Vec3Dd& cpp, double t){
+    const Vec3Dd p[4] = {controlPoints[knotIndex-1], controlPoints[knotIndex], controlPoints[knotIndex+1], controlPoints[knotIndex+2]};
+
+    const double &t0 = knotVector[knotIndex-1];
+    const double &t1 = knotVector[knotIndex];
+    const double &t2 = knotVector[knotIndex+1];
+    const double &t3 = knotVector[knotIndex+2];
+
+    Vec3Dd a1 = (t1-t)/(t1-t0)*p[0] + (t-t0)/(t1-t0)*p[1];
+    Vec3Dd a2 = (t2-t)/(t2-t1)*p[1] + (t-t1)/(t2-t1)*p[2];
+    Vec3Dd a3 = (t3-t)/(t3-t2)*p[2] + (t-t2)/(t3-t2)*p[3];
+
+    Vec3Dd a1p = 1.0/(t1-t0)*(p[1]-p[0]);
+    Vec3Dd a2p = 1.0/(t2-t1)*(p[2]-p[1]);
+    Vec3Dd a3p = 1.0/(t3-t2)*(p[3]-p[2]);
+
+    Vec3Dd b1 = (t2-t)/(t2-t0)*a1 + (t-t0)/(t2-t0)*a2;
+    Vec3Dd b2 = (t3-t)/(t3-t1)*a2 + (t-t1)/(t3-t1)*a3;
+
+    Vec3Dd b1p = 1.0/(t2-t0)*(a2-a1) + (t2-t)/(t2-t0)*a1p + (t-t0)/(t2-t0)*a2p;
+    Vec3Dd b2p = 1.0/(t3-t1)*(a3-a2) + (t3-t)/(t3-t1)*a2p + (t-t1)/(t3-t1)*a3p;
+
+    Vec3Dd b1pp = 1.0/(t2-t0)*(a2p-a1p);
+    Vec3Dd b2pp = 1.0/(t3-t1)*(a3p-a2p);
+
+    c = (t2-t)/(t2-t1)*b1 + (t-t1)/(t2-t1)*b2;
+    cp = 1.0/(t2-t1)*(b2-b1) + (t2-t)/(t2-t1)*b1p + (t-t1)/(t2-t1)*b2p;
+    cpp = 1.0/(t2-t1)*(b2p-b1p) + (t2-t)/(t2-t1)*b1pp + (t-t1)/(t2-t1)*b2pp;
+}
+
+void CurveGeometry::reportMemory(MemoryReport &report) const{
+    report.add("controlPoints", controlPoints);
+    report.add("curve", curve);
+    report.add("knotVector", knotVector);
+    report.add("spans", spans);
+    report.add("spanSamples", spanSamples);
+    report.add("spanBases", spanBases);
+    report.add("sampleOffsets", sampleOffsets);
+    report.add("basisKnots", basisKnots);
+    report.add("sampleParams", sampleParams);
+    report.add("segmentSamples", segmentSamples);
+    report.add("arcLength", arcLength);
+    report.add("dt", dt);
+    report.add("d2t", d2t);
+    report.add("frameNormals", frameNormals);
+    report.add("turningRates", turningRates);
+}
+
+void CurveGeometry::catmullrom(){
+    MEDMAX_TRACE("CurveGeometry::catmullrom");
+    curve.clear();
+    curve.resize(nbU);
+    dt.clear();
+    dt.resize(nbU);
+    d2t.clear();
+    d2t.resize(nbU);
+
+    catmullromSegments(1, getNbControlPoints()-3);
+}
+
+void CurveGeometry::catmullromSegments(unsigned int first, unsigned int last){
+    MEDMAX_TRACE("CurveGeometry::catmullromSegments");
+    for(unsigned int j=first; j<=last; j++){
+        knotIndex = j;
+
+        for(unsigned int i=segmentSamples[j-1]; i<segmentSamples[j]; i++){
+            calculateCatmullPoints(curve[i], dt[i], d2t[i], sampleParams[i]);
+        }
+    }
+}
+
+// Length as the crow flies
+double CurveGeometry::discreteLength(unsigned int indexS, unsigned int indexE) const{
+    const double dx = curve[indexE][0] - curve[indexS][0];
+    const double dy = curve[indexE][1] - curve[indexS][1];
+    const double dz = curve[indexE][2] - curve[indexS][2];
+    return sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+// Length of the chord
+double CurveGeometry::discreteChordLength(unsigned int indexS, unsigned int indexE) const{
+    return arcLength[indexE] - arcLength[indexS];
+}
+
+// Everything after start is recalculated (the lengths before start haven't changed)
+void CurveGeometry::computeArcLengths(unsigned int start){
+    arcLength.resize(curve.size());
+    if(curve.size()==0) return;
+
+    arcLength[0] = 0;
+    for(unsigned int i=std::max(start, 1u); i<curve.size(); i++) arcLength[i] = arcLength[i-1] + discreteLength(i-1, i);
+
+    arcLengthSlack = 1e-9 * (arcLength.back() + 1.0);
+}
+
+unsigned int CurveGeometry::arcIndexAfter(unsigned int index, double length) const{
+    const double target = arcLength[index] + length - arcLengthSlack;
+    unsigned int k = static_cast<unsigned int>(std::lower_bound(arcLength.begin()+index, arcLength.end(), target) - arcLength.begin());
+    if(k >= nbU) k = nbU-1;
+    return k;
+}
+
+unsigned int CurveGeometry::arcIndexBefore(unsigned int index, double length) const{
+    const double target = arcLength[index] - length + arcLengthSlack;
+    unsigned int k = static_cast<unsigned int>(std::upper_bound(arcLength.begin(), arcLength.begin()+index+1, target) - arcLength.begin());
+    if(k == 0) return 0;
+    return k-1;
+}
+
+unsigned int CurveGeometry::getClosestDistance(double target, unsigned int indexS, unsigned int a, unsigned int b) const{
+    double aDist = discreteLength(indexS, indexS+a);
+    double bDist = discreteLength(indexS, indexS+b);
+    double aTarget = fabs(target - aDist);
+    double bTarget = fabs(target - bDist);
+
+    if(aTarget < bTarget) return a;
+    return b;
+}
+
+// Returns the index which is length away from indexS
+// Same result as stepping one index at a time : from an index d away from indexS, the next (length-d) of arc can't reach length (a straight line is never longer than the arc)
+unsigned int CurveGeometry::indexForLength(unsigned int indexS, double length) const{
+    unsigned int i=0;
+
+    if(length > 0){
+        unsigned int k = indexS;
+        while(k < nbU-1){
+            double d = discreteLength(indexS, k);
+            if(d >= length) break;
+            k = std::max(arcIndexAfter(k, length - d), k+1);
+        }
+        i = k - indexS;
+        if(i!=0) i = getClosestDistance(length, indexS, i, i-1);
+    }
+    else{
+        unsigned int k = indexS;
+        while(k > 0){
+            double d = discreteLength(indexS, k);
+            if(d >= fabs(length)) break;
+            k = std::min(arcIndexBefore(k, fabs(length) - d), k-1);
+        }
+        i = k - indexS;     // wraps around like the index (indexS+i is still k)
+        if(i!=nbU-1) i = getClosestDistance(length, indexS, i, i+1);
+    }
+
+    return indexS+i;
+}
+
+// Frenet frame
+Vec3Dd CurveGeometry::tangent(unsigned int index) const{
+    Vec3Dd t = dt[index];
+    t.normalize();
+
+    return t;
+}
+
+Vec3Dd CurveGeometry::normal(unsigned int index) const{
+    return cross(binormal(index), tangent(index));
+}
+
+Vec3Dd CurveGeometry::binormal(unsigned int index) const{
+    Vec3Dd b = cross(dt[index], d2t[index]);
+    b.normalize();
+
+    return b;
+}
+
+void CurveGeometry::getFrame(unsigned int index, Vec3Dd &t, Vec3Dd &n, Vec3Dd &b) const{
+    t = tangent(index);
+    b = binormal(index);
+    n = cross(b, t);
+}
+
+// Double reflection (Wang et al. 2008) : reflect the previous frame onto the next sample, then reflect the tangent back onto the curve's
+void CurveGeometry::computeFrames(unsigned int start){
+    frameNormals.resize(nbU);
+    if(nbU==0) return;
+
+    if(start==0){       // start from the Frenet frame, or any normal if the curve is straight there
+        Vec3Dd t = tangent(0);
+        Vec3Dd b = cross(dt[0], d2t[0]);
+        Vec3Dd n;
+        if(b.getSquaredLength() > 1e-20) n = cross(b, t);
+        else n = orthogonalVec(t);
+        n.normalize();
+        frameNormals[0] = n;
+    }
+
+    for(unsigned int i=std::max(start, 1u); i<nbU; i++){
+        const Vec3Dd &n0 = frameNormals[i-1];
+        const Vec3Dd t0 = tangent(i-1);
+        const Vec3Dd t1 = tangent(i);
+
+        Vec3Dd v1 = curve[i] - curve[i-1];
+        double c1 = dot(v1, v1);
+        Vec3Dd nL = n0;
+        Vec3Dd tL = t0;
+        if(c1 > 0){
+            nL = n0 - (2.0/c1) * dot(v1, n0) * v1;
+            tL = t0 - (2.0/c1) * dot(v1, t0) * v1;
+        }
+
+        Vec3Dd v2 = t1 - tL;
+        double c2 = dot(v2, v2);
+        Vec3Dd n1 = nL;
+        if(c2 > 0) n1 = nL - (2.0/c2) * dot(v2, nL) * v2;
+
+        n1 -= dot(n1, t1) * t1;     // stop the rounding errors from building up along the curve
+        n1.normalize();
+        frameNormals[i] = n1;
+    }
+
+    turningRates.resize(nbU);
+    turningRates[0] = 0;
+    for(unsigned int i=std::max(start, 1u); i<nbU; i++){
+        const Vec3Dd t0 = tangent(i-1);
+        const Vec3Dd t1 = tangent(i);
+        const double length = discreteChordLength(i-1, i);
+        turningRates[i] = length > 0 ? atan2(cross(t0, t1).norm(), dot(t0, t1)) / length : 0;
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef CURVEGEOMETRY_H
+#define CURVEGEOMETRY_H
+
+#include "Vec3D.h"
+#include "memoryreport.h"
+#include <vector>
+
+/*
+ * The samples of a Catmull-Rom or B-spline curve through a list of control points, with the arc length table
+ * and the rotation minimising frames. Only plain C++, the Curve in the viewers wraps this one and draws it.
+ * Once generated the const functions can be called from several threads at once.
+*/
+class CurveGeometry
+{
+public:
+    CurveGeometry(const std::vector<Vec3Dd> &controlPoints);
+
+    void generateBSpline(unsigned int& nbU, unsigned int degree);
+    void generateCatmull(unsigned int& nbU);
+    void generateAdaptiveCatmull(double chordError, double maxSpacing, unsigned int& nbU);    // as many samples as needed to stay within chordError of the curve (and no further than maxSpacing apart)
+
+    unsigned int getNbControlPoints() const { return static_cast<unsigned int>(controlPoints.size()); }
+    const Vec3Dd& getControlPoint(unsigned int index) const { return controlPoints[index]; }
+    void setControlPoint(unsigned int index, const Vec3Dd &p){ controlPoints[index] = p; }
+
+    void regenerate();      // recalculate every sample with the current control points (keeps the samples' parameters)
+    unsigned int controlPointMoved(unsigned int index);     // only regenerates the segments which depend on this control point, returns the first sample which moved
+
+    const std::vector<Vec3Dd>& getCurve() const { return curve; }
+    const Vec3Dd& getPoint(unsigned int index) const { return curve[index]; }
+    unsigned int getNbU() const { return nbU; }
+
+    Vec3Dd tangent(unsigned int index) const;
+    Vec3Dd normal(unsigned int index) const;
+    Vec3Dd binormal(unsigned int index) const;
+    void getFrame(unsigned int index, Vec3Dd& t, Vec3Dd& n, Vec3Dd& b) const;
+
+    // Rotation minimising frames : the normal is the x axis, the tangent the z axis
+    const Vec3Dd& getFrameNormal(unsigned int index) const { return frameNormals[index]; }
+    double getTurningRate(unsigned int index) const { return turningRates[index]; }     // how much the tangent turns between the previous sample and this one (radians per mm)
+
+    double discreteLength(unsigned int indexS, unsigned int indexE) const;      // Returns the discrete length between 2 points (Straight line distance)
+    double discreteChordLength(unsigned int indexS, unsigned int indexE) const; // To use for the initial visualisation
+    unsigned int indexForLength(unsigned int indexS, double length) const;   // Returns the end index which will create a segment of a certain length
+    double getTotalLength() const { return arcLength.size()!=0 ? arcLength.back() : 0; }
+    double lengthAtIndex(unsigned int index) const { return arcLength[index]; }      // the length along the curve from the first sample
+    unsigned int indexAtLength(double length) const;      // the closest sample to a length along the curve
+
+    void reportMemory(MemoryReport &report) const;
+
+private:
+    std::vector<Vec3Dd> controlPoints;
+    std::vector<Vec3Dd> curve;
+    unsigned int nbU;
+
+    unsigned int degree;
+    std::vector<double> knotVector;
+    unsigned int knotIndex;
+
+    // BSpline
+    void generateUniformKnotVector(unsigned int k, std::vector<double>& kv);
+    void computeSpanBases();        // only depends on the knots, the degree and nbU
+    void bspline();     // calculate the spline and its first and second derivatives
+    bool isBSpline = false;
+
+    // Each span of the knot vector is a polynomial in (u - knot) : spanBases holds the (degree+1)x(degree+1) matrix which turns its control points into the polynomial's coefficients
+    std::vector<unsigned int> spans;        // the non empty spans
+    std::vector<unsigned int> spanSamples;  // the first sample of each span (and nbU at the end)
+    std::vector<double> spanBases;
+    std::vector<double> sampleOffsets;      // u - knot of each sample
+    std::vector<double> basisKnots;     // what the bases were calculated for
+    unsigned int basisDegree = 0;
+    unsigned int basisNbU = 0;
+
+    // Catmull rom
+    void catmullrom();  // calculate the spline and the first derivative
+    void catmullromSegments(unsigned int first, unsigned int last);     // recalculate the segments first to last (keeps the knot vector and the samples' parameters)
+    void subdivideSegment(double a, const Vec3Dd &pa, double b, const Vec3Dd &pb, double chordError, double maxSpacing, unsigned int depth);
+    std::vector<double> sampleParams;       // the knot parameter of each sample
+    std::vector<unsigned int> segmentSamples;       // the first sample of each segment (and nbU at the end)
+    void calculateCatmullPoints(Vec3Dd& c, Vec3Dd& cp, Vec3Dd& cpp, double t);
+
+    void generateCatmullKnotVector(double alpha, std::vector<double>& knotV);
+
+    unsigned int getClosestDistance(double target, unsigned int indexS, unsigned int a, unsigned int b) const;       // get the index which is closest to the target distance
+
+    // Arc length table (the length of the polyline from the start to each index)
+    void computeArcLengths(unsigned int start = 0);
+    unsigned int arcIndexAfter(unsigned int index, double length) const;     // the first index after index where the arc is at least length long
+    unsigned int arcIndexBefore(unsigned int index, double length) const;    // the last index before index where the arc is at least length long
+    std::vector<double> arcLength;
+    double arcLengthSlack;      // covers the rounding errors when comparing the table with straight line distances
+
+    // Frenet frame
+    std::vector<Vec3Dd> dt;
+    std::vector<Vec3Dd> d2t;
+
+    // Rotation minimising frames
+    void computeFrames(unsigned int start = 0);
+    std::vector<Vec3Dd> frameNormals;
+    std::vector<double> turningRates;
+};
+
+#endif // CURVEGEOMETRY_H
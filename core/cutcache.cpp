@@ -0,0 +1,87 @@
+#include "cutcache.h"
+#include <cmath>
+
+static const double positionSteps = 1e4;        // per mm
+static const double axisSteps = 1e6;
+
+template<typename T> static size_t getBytesOf(const std::vector<T> &v){ return v.size() * sizeof(T); }
+
+size_t CutCache::Entry::getBytes() const{
+    size_t total = getBytesOf(planes) + getBytesOf(flooding) + getBytesOf(planeNeighbours) + getBytesOf(trianglesCut) + getBytesOf(segmentsConserved)
+            + getBytesOf(moved) + getBytesOf(movedPositions) + getBytesOf(faces) + getBytesOf(faceNormals) + getBytesOf(touched) + getBytesOf(touchedNormals);
+    for(unsigned int i=0; i<intersections.size(); i++) total += getBytesOf(intersections[i]);
+    return total;
+}
+
+CutCache::Key CutCache::makeKey(const std::vector<CutPlane> &planes, int side){
+    Key key;
+    key.reserve(1 + 13 * planes.size());
+    key.push_back(side);
+    for(unsigned int i=0; i<planes.size(); i++){
+        const AffineFrame &frame = planes[i].getFrame();
+        for(int k=0; k<3; k++) key.push_back(std::llround(frame.getOrigin()[k] * positionSteps));
+        for(unsigned int a=0; a<3; a++){
+            for(int k=0; k<3; k++) key.push_back(std::llround(frame.getAxis(a)[k] * axisSteps));
+        }
+        key.push_back(std::llround(planes[i].getSize() * positionSteps));
+    }
+    return key;
+}
+
+const CutCache::Entry* CutCache::find(const Key &key){
+    std::map<Key, Entries::iterator>::iterator found = positions.find(key);
+    if(found == positions.end()){
+        nbMisses++;
+        return nullptr;
+    }
+
+    nbHits++;
+    entries.splice(entries.begin(), entries, found->second);        // the iterators stay valid
+    return &found->second->second;
+}
+
+void CutCache::insert(const Key &key, Entry &entry){
+    if(!isEnabled()) return;
+
+    std::map<Key, Entries::iterator>::iterator found = positions.find(key);
+    if(found != positions.end()){
+        bytes -= found->second->second.getBytes();
+        entries.erase(found->second);
+        positions.erase(found);
+    }
+
+    entries.push_front(std::make_pair(key, Entry()));
+    std::swap(entries.front().second, entry);
+    positions[key] = entries.begin();
+    bytes += entries.front().second.getBytes();
+    evict();
+}
+
+void CutCache::clear(){
+    entries.clear();
+    positions.clear();
+    bytes = 0;
+}
+
+void CutCache::setMaxBytes(size_t maxBytes){
+    this->maxBytes = maxBytes;
+    evict();
+}
+
+void CutCache::evict(){
+    while(bytes > maxBytes && !entries.empty()){
+        bytes -= entries.back().second.getBytes();
+        positions.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+void CutCache::reportMemory(MemoryReport &report) const{
+    MemoryReport::Buffer b;
+    b.name = "cutCache";
+    b.nbElements = entries.size();
+    b.usedBytes = bytes;
+    b.allocatedBytes = bytes;
+    for(Entries::const_iterator e=entries.begin(); e!=entries.end(); e++) b.allocatedBytes += 2 * e->first.capacity() * sizeof(int64_t);      // the keys are in the list and the map
+    report.add(b);
+}
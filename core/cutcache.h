@@ -0,0 +1,74 @@
+#ifndef CUTCACHE_H
+#define CUTCACHE_H
+
+#include "Vec3D.h"
+#include "cutplane.h"
+#include "memoryreport.h"
+#include <cstdint>
+#include <list>
+#include <map>
+#include <vector>
+
+/*
+ * The results of the last cuts of a mesh, for when the sliders go back over the same positions.
+ * The planes are keyed once rounded (0.1 micron, 1e-6 on the axes) : the frames rotated back and forth don't come back
+ * exactly the same, but the curve indicies, rotations and ghost layout they come from are.
+ * Once the entries take more than maxBytes the least recently used ones are dropped (0 : nothing is kept).
+*/
+class CutCache
+{
+public:
+    typedef std::vector<int64_t> Key;
+
+    // What MeshGeometry needs to put the cut back, the index lists as varint deltas and the flooding as runs
+    struct Entry{
+        std::vector<CutPlane> planes;       // the planes the intersections were found for
+        std::vector<std::vector<uint8_t>> intersections;
+        std::vector<uint8_t> flooding;
+        std::vector<int> planeNeighbours;
+        std::vector<uint8_t> trianglesCut;
+        std::vector<int> segmentsConserved;
+
+        // The smoothed overlay : only what differs from the mesh
+        std::vector<unsigned int> moved;
+        std::vector<Vec3Df> movedPositions;
+        std::vector<unsigned int> faces;
+        std::vector<Vec3Df> faceNormals;
+        std::vector<unsigned int> touched;
+        std::vector<Vec3Df> touchedNormals;
+
+        size_t getBytes() const;
+    };
+
+    CutCache(size_t maxBytes = 0) : maxBytes(maxBytes){}
+
+    static Key makeKey(const std::vector<CutPlane> &planes, int side);
+
+    const Entry* find(const Key &key);      // counts a hit or a miss, nullptr if it isn't there
+    void insert(const Key &key, Entry &entry);      // takes the entry's buffers
+    void clear();       // the hits and misses are kept
+
+    void setMaxBytes(size_t maxBytes);
+    size_t getMaxBytes() const { return maxBytes; }
+    bool isEnabled() const { return maxBytes != 0; }
+    size_t getBytes() const { return bytes; }
+    size_t getNbEntries() const { return entries.size(); }
+    unsigned long long getNbHits() const { return nbHits; }
+    unsigned long long getNbMisses() const { return nbMisses; }
+
+    void reportMemory(MemoryReport &report) const;
+
+private:
+    typedef std::list<std::pair<Key, Entry>> Entries;
+
+    void evict();       // until the entries fit in maxBytes
+
+    Entries entries;        // the most recently used first
+    std::map<Key, Entries::iterator> positions;
+    size_t maxBytes;
+    size_t bytes = 0;
+    unsigned long long nbHits = 0;
+    unsigned long long nbMisses = 0;
+};
+
+#endif // CUTCACHE_H
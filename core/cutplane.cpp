@@ -0,0 +1,41 @@
+#include "cutplane.h"
+
+bool CutPlane::isIntersection(const Vec3Dd &v0, const Vec3Dd &v1, const Vec3Dd &v2) const{
+
+    // Put it all into local coordinates
+    const Vec3Dd tr[3] = {frame.localCoordinatesOf(v0), frame.localCoordinatesOf(v1), frame.localCoordinatesOf(v2)};
+
+    if( (tr[0][2] < 0 && tr[1][2] < 0 && tr[2][2] < 0) || (tr[0][2] > 0 && tr[1][2] > 0 && tr[2][2] > 0) ) return false;  // if they all have the same sign
+
+    for(int i=0; i<3; i++){
+        const Vec3Dd &a = tr[i];
+        const Vec3Dd &b = tr[(i+1)%3];
+        Vec3Dd l = b - a;
+
+        if(l[2] == 0.0){
+            if(a[2] == 0.0){
+                if( (fabs(a[0]) < size && fabs(a[1]) < size) || (fabs(b[0]) < size && fabs(b[1]) < size) ) return true;  // the plane contains the line
+            }
+            continue;  // the line is parallel
+        }
+
+        double d = -a[2] / l[2];
+
+        if(fabs(d) > 1.0) continue;
+
+        Vec3Dd intersection = d*l + a;
+        if(fabs(intersection[0]) < size && fabs(intersection[1]) < size) return true;
+    }
+
+    return false;   // if we haven't found a line that meets the criteria
+}
+
+double CutPlane::getSign(const Vec3Dd &v) const{
+    const double z = Vec3Dd::dotProduct(v - frame.getOrigin(), getNormal());
+    return z/fabs(z);
+}
+
+Vec3Dd CutPlane::getProjection(const Vec3Dd &p) const{
+    const Vec3Dd &n = getNormal();
+    return p - n * Vec3Dd::dotProduct(p - frame.getOrigin(), n);
+}
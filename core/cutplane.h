@@ -0,0 +1,30 @@
+#ifndef CUTPLANE_H
+#define CUTPLANE_H
+
+#include "affineframe.h"
+
+// A square cutting plane : the z axis of its frame is the normal, it reaches size in x and y from the origin
+class CutPlane
+{
+public:
+    CutPlane() : size(0){}
+    CutPlane(const AffineFrame &frame, double size) : frame(frame), size(size){}
+
+    const AffineFrame& getFrame() const { return frame; }
+    double getSize() const { return size; }
+    const Vec3Dd& getPosition() const { return frame.getOrigin(); }
+    const Vec3Dd& getNormal() const { return frame.getAxis(2); }
+
+    bool isIntersection(const Vec3Dd &v0, const Vec3Dd &v1, const Vec3Dd &v2) const;      // whether the triangle crosses the square
+    double getSign(const Vec3Dd &v) const;      // which side of the plane v is on
+    Vec3Dd getProjection(const Vec3Dd &p) const;
+
+    bool operator==(const CutPlane &p) const { return size == p.size && frame == p.frame; }
+    bool operator!=(const CutPlane &p) const { return !(*this == p); }
+
+private:
+    AffineFrame frame;
+    double size;
+};
+
+#endif // CUTPLANE_H
@@ -0,0 +1,10 @@
+#ifndef FIBULAPLANNING_H
+#define FIBULAPLANNING_H
+
+// What the fibula viewer and the PieceCountEvaluator both use to place the pieces on the fibula, so the evaluation matches the viewer
+namespace FibulaPlanning{
+    const double ghostPlaneSize = 25.0;     // the ghost planes in the fibula (mm)
+    const double approachSecurity = 15.0;       // the bone left between two pieces brought together (mm)
+}
+
+#endif // FIBULAPLANNING_H
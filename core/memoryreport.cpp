@@ -0,0 +1,105 @@
+#include "memoryreport.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+void MemoryReport::add(const std::string &prefix, const MemoryReport &report){
+    for(size_t i=0; i<report.buffers.size(); i++){
+        buffers.push_back(report.buffers[i]);
+        buffers.back().name = prefix + buffers.back().name;
+    }
+}
+
+size_t MemoryReport::getUsedBytes() const{
+    size_t total = 0;
+    for(size_t i=0; i<buffers.size(); i++) total += buffers[i].usedBytes;
+    return total;
+}
+
+size_t MemoryReport::getAllocatedBytes() const{
+    size_t total = 0;
+    for(size_t i=0; i<buffers.size(); i++) total += buffers[i].allocatedBytes;
+    return total;
+}
+
+void MemoryReport::print(std::ostream &out) const{
+    out << std::left << std::setw(36) << "buffer" << std::right << std::setw(12) << "elements" << std::setw(14) << "used (KB)"
+        << std::setw(16) << "allocated (KB)" << std::setw(12) << "overhead" << std::endl;
+
+    out << std::fixed << std::setprecision(1);
+    for(size_t i=0; i<buffers.size(); i++){
+        const Buffer &b = buffers[i];
+        const double overhead = b.allocatedBytes!=0 ? 100. * static_cast<double>(b.allocatedBytes - std::min(b.usedBytes, b.allocatedBytes)) / static_cast<double>(b.allocatedBytes) : 0;
+        out << std::left << std::setw(36) << b.name << std::right << std::setw(12) << b.nbElements << std::setw(14) << static_cast<double>(b.usedBytes) / 1024.
+            << std::setw(16) << static_cast<double>(b.allocatedBytes) / 1024. << std::setw(11) << overhead << "%" << std::endl;
+    }
+    out << std::left << std::setw(36) << "total" << std::right << std::setw(12) << "" << std::setw(14) << static_cast<double>(getUsedBytes()) / 1024.
+        << std::setw(16) << static_cast<double>(getAllocatedBytes()) / 1024. << std::endl;
+    out << std::defaultfloat;
+}
+
+#ifdef MEDMAX_MEMORY_TRACKING
+
+namespace{
+    std::atomic<size_t> currentBytes(0);
+    std::atomic<size_t> peakBytes(0);
+
+    // Each block starts with its size, kept aligned for anything
+    const size_t headerSize = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+    void* trackedAlloc(size_t size){
+        void *block = std::malloc(size + headerSize);
+        if(!block) return nullptr;
+        *static_cast<size_t*>(block) = size;
+
+        const size_t current = currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = peakBytes.load(std::memory_order_relaxed);
+        while(current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+
+        return static_cast<char*>(block) + headerSize;
+    }
+
+    void trackedFree(void *p){
+        if(!p) return;
+        void *block = static_cast<char*>(p) - headerSize;
+        currentBytes.fetch_sub(*static_cast<size_t*>(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+
+    void* trackedNew(size_t size){
+        if(size == 0) size = 1;
+        while(true){
+            void *p = trackedAlloc(size);
+            if(p) return p;
+            std::new_handler handler = std::get_new_handler();
+            if(!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+}
+
+void* operator new(size_t size){ return trackedNew(size); }
+void* operator new[](size_t size){ return trackedNew(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept{ return trackedAlloc(size == 0 ? 1 : size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept{ return trackedAlloc(size == 0 ? 1 : size); }
+void operator delete(void *p) noexcept{ trackedFree(p); }
+void operator delete[](void *p) noexcept{ trackedFree(p); }
+void operator delete(void *p, size_t) noexcept{ trackedFree(p); }
+void operator delete[](void *p, size_t) noexcept{ trackedFree(p); }
+void operator delete(void *p, const std::nothrow_t&) noexcept{ trackedFree(p); }
+void operator delete[](void *p, const std::nothrow_t&) noexcept{ trackedFree(p); }
+
+size_t MemoryTracker::getCurrentBytes(){ return currentBytes.load(std::memory_order_relaxed); }
+size_t MemoryTracker::getPeakBytes(){ return peakBytes.load(std::memory_order_relaxed); }
+void MemoryTracker::resetPeak(){ peakBytes.store(currentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+#else
+
+size_t MemoryTracker::getCurrentBytes(){ return 0; }
+size_t MemoryTracker::getPeakBytes(){ return 0; }
+void MemoryTracker::resetPeak(){}
+
+#endif
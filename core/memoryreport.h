@@ -0,0 +1,77 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * The bytes held by each buffer of the meshes and curves. used counts only what the elements need,
+ * allocated what the vectors actually hold : the spare capacity, the inner vectors of a vector of vectors
+ * and whatever the elements carry beyond their data (padding, vtable pointers).
+*/
+class MemoryReport
+{
+public:
+    struct Buffer{
+        std::string name;
+        size_t nbElements = 0;
+        size_t usedBytes = 0;
+        size_t allocatedBytes = 0;
+    };
+
+    // payload is what one element needs (less than sizeof(T) when T carries more than its data)
+    template<typename T> void add(const std::string &name, const std::vector<T> &v, size_t payload = sizeof(T)){
+        Buffer b;
+        b.name = name;
+        b.nbElements = v.size();
+        b.usedBytes = v.size() * payload;
+        b.allocatedBytes = v.capacity() * sizeof(T);
+        buffers.push_back(b);
+    }
+
+    template<typename T> void add(const std::string &name, const std::vector<std::vector<T>> &v){
+        Buffer b;
+        b.name = name;
+        b.allocatedBytes = v.capacity() * sizeof(std::vector<T>);
+        for(size_t i=0; i<v.size(); i++){
+            b.nbElements += v[i].size();
+            b.usedBytes += v[i].size() * sizeof(T);
+            b.allocatedBytes += v[i].capacity() * sizeof(T);
+        }
+        buffers.push_back(b);
+    }
+
+    void add(const std::string &prefix, const MemoryReport &report);        // every buffer of report, named prefix + name
+    void add(const Buffer &buffer){ buffers.push_back(buffer); }        // for what isn't held in vectors
+
+    const std::vector<Buffer>& getBuffers() const { return buffers; }
+    size_t getUsedBytes() const;
+    size_t getAllocatedBytes() const;
+
+    void print(std::ostream &out) const;
+
+private:
+    std::vector<Buffer> buffers;
+};
+
+/*
+ * Every allocation of the process, counted by replacing the global operator new and delete.
+ * Only compiled in with MEDMAX_MEMORY_TRACKING (qmake CONFIG+=memtrack), the counts are 0 otherwise.
+*/
+namespace MemoryTracker{
+    constexpr bool isEnabled(){
+#ifdef MEDMAX_MEMORY_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    size_t getCurrentBytes();
+    size_t getPeakBytes();
+    void resetPeak();       // the peak starts again from what's allocated now
+}
+
+#endif // MEMORYREPORT_H
@@ -0,0 +1,809 @@
+#include "meshgeometry.h"
+#include "meshreorder.h"
+#include "trace.h"
+#include "varint.h"
+#include "vec3kernels.h"
+#include <algorithm>
+#include <queue>
+#include <float.h>
+#include <cmath>
+
+static const unsigned int normalsBlockSize = 4096;        // triangles or verticies per task
+static const double slabHalfWidth = 2.0;        // how far the planes can be from the samples' planes and still use the slab index (mm)
+static const size_t slabMaxBytes = 16 << 20;
+
+static Vec3Dd toDouble(const Vec3Df &v){
+    return Vec3Dd(static_cast<double>(v[0]), static_cast<double>(v[1]), static_cast<double>(v[2]));
+}
+
+static Vec3Df toFloat(const Vec3Dd &v){
+    return Vec3Df(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]));
+}
+
+// The verticies along a Morton curve, so that the flooding and the plane tests read neighbours close together,
+// then the triangles in Tipsify order for the vertex cache when drawing
+void MeshGeometry::reorderForLocality(bool isAgain){
+    MEDMAX_TRACE("MeshGeometry::reorderForLocality");
+    const std::vector<unsigned int> vertexOrder = MeshReorder::mortonOrder(vertices);
+    const std::vector<unsigned int> newVertex = MeshReorder::invert(vertexOrder);
+
+    std::vector<Vec3Df> reordered(vertices.size());
+    for(unsigned int i=0; i<vertices.size(); i++) reordered[i] = vertices[vertexOrder[i]];
+    vertices.swap(reordered);
+    if(verticesNormals.size() == vertices.size()){
+        for(unsigned int i=0; i<vertices.size(); i++) reordered[i] = verticesNormals[vertexOrder[i]];
+        verticesNormals.swap(reordered);
+    }
+
+    for(unsigned int i=0; i<triangles.size(); i++){
+        for(unsigned int j=0; j<3; j++) triangles[i].setVertex(j, newVertex[triangles[i].getVertex(j)]);
+    }
+
+    const std::vector<unsigned int> triangleOrder = MeshReorder::tipsifyOrder(triangles, static_cast<unsigned int>(vertices.size()));
+    std::vector<Triangle> reorderedTriangles(triangles.size());
+    for(unsigned int i=0; i<triangles.size(); i++) reorderedTriangles[i] = triangles[triangleOrder[i]];
+    triangles.swap(reorderedTriangles);
+
+    if(!isAgain || originalVertices.size() != vertices.size() || originalTriangles.size() != triangles.size()){
+        originalVertices = vertexOrder;
+        originalTriangles = triangleOrder;
+    }
+    else{
+        std::vector<unsigned int> composed(vertexOrder.size());
+        for(unsigned int i=0; i<vertexOrder.size(); i++) composed[i] = originalVertices[vertexOrder[i]];
+        originalVertices.swap(composed);
+        composed.resize(triangleOrder.size());
+        for(unsigned int i=0; i<triangleOrder.size(); i++) composed[i] = originalTriangles[triangleOrder[i]];
+        originalTriangles.swap(composed);
+    }
+
+    oneRing.clear();
+    triangleRingStart.clear();
+    triangleRing.clear();
+    triangleNormals.clear();
+    slabIndex.clear();
+    clearCut();
+}
+
+void MeshGeometry::getInOriginalOrder(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles) const{
+    if(originalVertices.size() != this->vertices.size() || originalTriangles.size() != this->triangles.size()){
+        vertices = this->vertices;
+        triangles = this->triangles;
+        return;
+    }
+
+    vertices.resize(this->vertices.size());
+    for(unsigned int i=0; i<this->vertices.size(); i++) vertices[originalVertices[i]] = this->vertices[i];
+
+    triangles.resize(this->triangles.size());
+    for(unsigned int i=0; i<this->triangles.size(); i++){
+        const Triangle &t = this->triangles[i];
+        triangles[originalTriangles[i]] = Triangle(originalVertices[t.getVertex(0)], originalVertices[t.getVertex(1)], originalVertices[t.getVertex(2)]);
+    }
+}
+
+void MeshGeometry::collectOneRings(){
+    slabIndex.clear();
+    cutCache.clear();
+    oneRing.assign(vertices.size(), std::vector<unsigned int>());
+
+    // Counted first, then filled in the order of the triangles
+    triangleRingStart.assign(vertices.size() + 1, 0);
+    for (unsigned int i = 0; i < triangles.size (); i++) {
+        for (unsigned int j = 0; j < 3; j++) triangleRingStart[triangles[i].getVertex(j) + 1]++;
+    }
+    for (unsigned int v = 0; v < vertices.size(); v++) triangleRingStart[v+1] += triangleRingStart[v];
+    triangleRing.resize(triangleRingStart.back());
+    std::vector<unsigned int> next(triangleRingStart.begin(), triangleRingStart.end() - 1);
+
+    for (unsigned int i = 0; i < triangles.size (); i++) {
+        const Triangle &ti = triangles[i];
+        for (unsigned int j = 0; j < 3; j++) {
+            unsigned int vj = ti.getVertex(j);
+            triangleRing[next[vj]++] = i;
+            for (unsigned int k = 1; k < 3; k++) {
+                unsigned int vk = ti.getVertex((j+k)%3);
+                if (std::find (oneRing[vj].begin (), oneRing[vj].end (), vk) == oneRing[vj].end ())
+                    oneRing[vj].push_back(vk);
+            }
+        }
+    }
+
+    clearCut();     // new triangles, the saved intersections are out of date
+}
+
+void MeshGeometry::computeBB(Vec3Df &centre, float &radius) const{
+    Vec3Df BBMin, BBMax;
+    Vec3Kernels::boundingBox(vertices, BBMin, BBMax);
+
+    radius = (BBMax - BBMin).norm() / 2.0f;
+    centre = (BBMax + BBMin)/2.0f;
+}
+
+void MeshGeometry::recomputeNormals () {
+    computeVerticesNormals(ThreadPool::global());
+}
+
+void MeshGeometry::recomputeNormals(ThreadPool &pool){
+    computeVerticesNormals(pool);
+}
+
+void MeshGeometry::updateNormals(const std::vector<unsigned int> &movedVertices){
+    if(triangleNormals.size() != triangles.size() || verticesNormals.size() != vertices.size()){
+        computeVerticesNormals(ThreadPool::global());
+        return;
+    }
+    std::vector<unsigned int> faces, touched;
+    updateNormals(vertices, movedVertices, std::vector<bool>(), triangleNormals, verticesNormals, faces, touched);
+    resetSmoothed();
+}
+
+Vec3Df MeshGeometry::computeTriangleNormal(const std::vector<Vec3Df> &positions, unsigned int id ) const{
+    const Triangle &t = triangles[id];
+    Vec3Df normal = Vec3Df::crossProduct(positions[t.getVertex (1)] - positions[t.getVertex (0)], positions[t.getVertex (2)]- positions[t.getVertex (0)]);
+    normal.normalize();
+    return normal;
+}
+
+/*
+ * The triangle normals first, then each vertex adds up the normals of its triangles : every block writes its own
+ * verticies only, so the blocks run in parallel without atomics. The triangles of a vertex are in the order of the triangles,
+ * which gives the same sums as adding each triangle normal to its verticies.
+ * Without the one rings (before collectOneRings) the triangle normals are added to their verticies on the calling thread.
+*/
+void MeshGeometry::computeVerticesNormals(ThreadPool &pool){
+    MEDMAX_TRACE("MeshGeometry::computeVerticesNormals");
+    const unsigned int nbVertices = static_cast<unsigned int>(vertices.size());
+    const unsigned int nbTriangles = static_cast<unsigned int>(triangles.size());
+    resetSmoothed();
+
+    if(triangleRingStart.size() != nbVertices + 1){
+        triangleNormals.clear();
+        verticesNormals.assign(nbVertices, Vec3Df(0.,0.,0.));
+        Vec3Kernels::accumulateTriangleNormals(vertices, triangles, verticesNormals);
+        Vec3Kernels::normalize(verticesNormals);
+        return;
+    }
+
+    triangleNormals.resize(nbTriangles);
+    pool.parallelFor(0, (nbTriangles + normalsBlockSize - 1) / normalsBlockSize, [this, nbTriangles](unsigned int b){
+        const unsigned int start = b * normalsBlockSize;
+        Vec3Kernels::triangleNormals(vertices, &triangles[start], std::min(normalsBlockSize, nbTriangles - start), &triangleNormals[start]);
+    });
+
+    verticesNormals.resize(nbVertices);
+    pool.parallelFor(0, (nbVertices + normalsBlockSize - 1) / normalsBlockSize, [this, nbVertices](unsigned int b){
+        const unsigned int start = b * normalsBlockSize;
+        const unsigned int end = std::min(start + normalsBlockSize, nbVertices);
+        for(unsigned int v=start; v<end; v++){
+            Vec3Df n(0.,0.,0.);
+            for(unsigned int a=triangleRingStart[v]; a<triangleRingStart[v+1]; a++) n += triangleNormals[triangleRing[a]];
+            verticesNormals[v] = n;
+        }
+        Vec3Kernels::normalize(&verticesNormals[start], end - start);
+    });
+}
+
+// The marks are only set for the triangles and verticies in the lists, and cleared from the lists, so the cost only depends on how many verticies moved
+void MeshGeometry::updateNormals(const std::vector<Vec3Df> &positions, const std::vector<unsigned int> &moved, const std::vector<bool> &isUsed, std::vector<Vec3Df> &faceNormals,
+                                 std::vector<Vec3Df> &normals, std::vector<unsigned int> &faces, std::vector<unsigned int> &touched){
+    if(isFaceMarked.size() != triangles.size()) isFaceMarked.assign(triangles.size(), false);
+    if(isVertexMarked.size() != vertices.size()) isVertexMarked.assign(vertices.size(), false);
+
+    faces.clear();
+    for(unsigned int i=0; i<moved.size(); i++){
+        for(unsigned int a=triangleRingStart[moved[i]]; a<triangleRingStart[moved[i]+1]; a++){
+            const unsigned int t = triangleRing[a];
+            if(isFaceMarked[t]) continue;
+            isFaceMarked[t] = true;
+            faces.push_back(t);
+        }
+    }
+
+    touched.clear();
+    for(unsigned int i=0; i<faces.size(); i++){
+        faceNormals[faces[i]] = computeTriangleNormal(positions, faces[i]);
+        isFaceMarked[faces[i]] = false;
+        for(unsigned int j=0; j<3; j++){
+            const unsigned int v = triangles[faces[i]].getVertex(j);
+            if(isVertexMarked[v]) continue;
+            isVertexMarked[v] = true;
+            touched.push_back(v);
+        }
+    }
+
+    const bool isAllUsed = isUsed.size() != triangles.size();
+    for(unsigned int i=0; i<touched.size(); i++){
+        const unsigned int v = touched[i];
+        Vec3Df n(0.,0.,0.);
+        for(unsigned int a=triangleRingStart[v]; a<triangleRingStart[v+1]; a++){
+            if(isAllUsed || isUsed[triangleRing[a]]) n += faceNormals[triangleRing[a]];
+        }
+        n.normalize();
+        normals[v] = n;
+        isVertexMarked[v] = false;
+    }
+}
+
+void MeshGeometry::clearCut(){
+    intersectionTriangles.clear();
+    intersectionPlanes.clear();
+    resetSmoothed();
+}
+
+void MeshGeometry::resetSmoothed(){
+    smoothedVerticies.clear();
+    smoothedNormals.clear();
+    smoothedTriangleNormals.clear();
+    smoothedMoved.clear();
+    smoothedFaces.clear();
+    smoothedTouched.clear();
+    cutCache.clear();
+}
+
+void MeshGeometry::setCutPlanes(const std::vector<CutPlane> &planes, Side side){
+    cutPlanes = planes;
+    cuttingSide = side;
+}
+
+void MeshGeometry::cut(const std::vector<CutPlane> &planes, Side side, ThreadPool &pool){
+    setCutPlanes(planes, side);
+    if(restoreCut()) return;
+
+    intersectPlanes(pool);
+    seedPlaneSides();
+    floodFromIntersections();
+    mergeFlood();
+    cutMesh();      // ! Conserve this order
+    createSmoothedTriangles();
+    updateSmoothedNormals();
+    saveCut();
+}
+
+// The intersections and the cut as index lists, the flooding as runs of the same value and the smoothed overlay where it differs from the mesh
+void MeshGeometry::saveCut(){
+    if(!cutCache.isEnabled()) return;
+    MEDMAX_TRACE("MeshGeometry::saveCut");
+
+    CutCache::Entry entry;
+    entry.planes = intersectionPlanes;
+    entry.intersections.resize(intersectionTriangles.size());
+    for(unsigned int i=0; i<intersectionTriangles.size(); i++) Varint::appendDeltas(entry.intersections[i], intersectionTriangles[i]);
+
+    for(unsigned int i=0; i<flooding.size();){
+        unsigned int end = i+1;
+        while(end < flooding.size() && flooding[end] == flooding[i]) end++;
+        Varint::append(entry.flooding, end - i);
+        Varint::append(entry.flooding, Varint::zigzag(flooding[i]));
+        i = end;
+    }
+
+    entry.planeNeighbours = planeNeighbours;
+    Varint::appendDeltas(entry.trianglesCut, trianglesCut);
+    entry.segmentsConserved = segmentsConserved;
+
+    entry.moved = smoothedMoved;
+    for(unsigned int i=0; i<smoothedMoved.size(); i++) entry.movedPositions.push_back(smoothedVerticies[smoothedMoved[i]]);
+    if(smoothedNormals.size() == vertices.size()){
+        entry.faces = smoothedFaces;
+        for(unsigned int i=0; i<smoothedFaces.size(); i++) entry.faceNormals.push_back(smoothedTriangleNormals[smoothedFaces[i]]);
+        entry.touched = smoothedTouched;
+        for(unsigned int i=0; i<smoothedTouched.size(); i++) entry.touchedNormals.push_back(smoothedNormals[smoothedTouched[i]]);
+    }
+
+    cutCache.insert(CutCache::makeKey(cutPlanes, static_cast<int>(cuttingSide)), entry);
+}
+
+// Leaves the mesh as the stages would : the overlay of the last cut is put back to the mesh before the cached one goes on
+bool MeshGeometry::restoreCut(){
+    if(!cutCache.isEnabled()) return false;
+    const CutCache::Entry *entry = cutCache.find(CutCache::makeKey(cutPlanes, static_cast<int>(cuttingSide)));
+    if(entry == nullptr) return false;
+    MEDMAX_TRACE("MeshGeometry::restoreCut");
+
+    intersectionPlanes = entry->planes;
+    intersectionTriangles.resize(entry->intersections.size());
+    for(unsigned int i=0; i<entry->intersections.size(); i++) Varint::readDeltas(entry->intersections[i], intersectionTriangles[i]);
+
+    flooding.clear();
+    flooding.reserve(vertices.size());
+    for(size_t position=0; position<entry->flooding.size();){
+        const uint32_t length = Varint::read(entry->flooding, position);
+        flooding.insert(flooding.end(), length, Varint::unzigzag(Varint::read(entry->flooding, position)));
+    }
+
+    planeNeighbours = entry->planeNeighbours;
+    Varint::readDeltas(entry->trianglesCut, trianglesCut);
+    segmentsConserved = entry->segmentsConserved;
+
+    isTriangleKept.assign(triangles.size(), false);
+    for(unsigned int i=0; i<trianglesCut.size(); i++) isTriangleKept[trianglesCut[i]] = true;
+    trianglesExtracted.clear();
+    for(unsigned int i=0; i<triangles.size(); i++){
+        if(!isTriangleKept[i]) trianglesExtracted.push_back(i);
+    }
+
+    if(smoothedVerticies.size() != vertices.size()) smoothedVerticies = vertices;
+    else for(unsigned int i=0; i<smoothedMoved.size(); i++) smoothedVerticies[smoothedMoved[i]] = vertices[smoothedMoved[i]];
+    smoothedMoved = entry->moved;
+    for(unsigned int i=0; i<smoothedMoved.size(); i++) smoothedVerticies[smoothedMoved[i]] = entry->movedPositions[i];
+
+    if(triangleNormals.size() == triangles.size()){
+        if(smoothedNormals.size() != vertices.size()){
+            smoothedNormals = verticesNormals;
+            smoothedTriangleNormals = triangleNormals;
+        }
+        else{
+            for(unsigned int i=0; i<smoothedFaces.size(); i++) smoothedTriangleNormals[smoothedFaces[i]] = triangleNormals[smoothedFaces[i]];
+            for(unsigned int i=0; i<smoothedTouched.size(); i++) smoothedNormals[smoothedTouched[i]] = verticesNormals[smoothedTouched[i]];
+        }
+        smoothedFaces = entry->faces;
+        for(unsigned int i=0; i<smoothedFaces.size(); i++) smoothedTriangleNormals[smoothedFaces[i]] = entry->faceNormals[i];
+        smoothedTouched = entry->touched;
+        for(unsigned int i=0; i<smoothedTouched.size(); i++) smoothedNormals[smoothedTouched[i]] = entry->touchedNormals[i];
+    }
+    return true;
+}
+
+// The planes are independent, test them at the same time
+void MeshGeometry::intersectPlanes(ThreadPool &pool){
+    MEDMAX_TRACE("MeshGeometry::intersectPlanes");
+    // A new plane starts with an empty list for an empty plane (which doesn't cut anything), so the lists always match their planes
+    intersectionTriangles.resize(cutPlanes.size());
+    intersectionPlanes.resize(cutPlanes.size());
+
+    pool.parallelFor(0, static_cast<unsigned int>(cutPlanes.size()), [this](unsigned int i){
+        if(intersectionPlanes[i] == cutPlanes[i]) return;       // exact comparison, a plane which moved slightly can still cut other triangles
+
+        planeIntersection(cutPlanes[i], intersectionTriangles[i]);
+        intersectionPlanes[i] = cutPlanes[i];
+    });
+}
+
+void MeshGeometry::buildSlabIndex(const CurveGeometry &curve, double planeSize, ThreadPool &pool){
+    MEDMAX_TRACE("MeshGeometry::buildSlabIndex");
+    slabIndex.build(vertices, triangles, curve, slabHalfWidth, planeSize * std::sqrt(2.0) + slabHalfWidth, slabMaxBytes, pool);
+}
+
+void MeshGeometry::updateSlabIndex(const CurveGeometry &curve, unsigned int start, unsigned int end, ThreadPool &pool){
+    MEDMAX_TRACE("MeshGeometry::updateSlabIndex");
+    slabIndex.update(vertices, triangles, curve, start, end, pool);
+}
+
+// Finds all the intersecting triangles for a plane, only among the triangles near it when it's on the curve
+void MeshGeometry::planeIntersection(const CutPlane &plane, std::vector <unsigned int> &intersectionTrianglesPlane) const{
+    intersectionTrianglesPlane.clear();       // empty the list of intersections
+
+    std::vector<unsigned int> candidates;
+    if(slabIndex.getCandidates(plane, candidates)){
+        for(unsigned int k=0; k<candidates.size(); k++){
+            const Triangle &t = triangles[candidates[k]];
+            if(plane.isIntersection(toDouble(vertices[t.getVertex(0)]), toDouble(vertices[t.getVertex(1)]), toDouble(vertices[t.getVertex(2)]))) intersectionTrianglesPlane.push_back(candidates[k]);
+        }
+        return;
+    }
+
+    for(unsigned int i = 0 ; i < triangles.size(); i++){
+        const unsigned int &t0 = triangles[i].getVertex(0);
+        const unsigned int &t1 = triangles[i].getVertex(1);
+        const unsigned int &t2 = triangles[i].getVertex(2);
+
+        if(plane.isIntersection(toDouble(vertices[t0]), toDouble(vertices[t1]), toDouble(vertices[t2]))){        // if the triangle intersects the plane
+            intersectionTrianglesPlane.push_back(i);      // save the triangle index
+        }
+    }
+}
+
+// Writes to the shared flooding table so the planes are done in order
+void MeshGeometry::seedPlaneSides(){
+    MEDMAX_TRACE("MeshGeometry::seedPlaneSides");
+    flooding.clear();
+    flooding.resize(vertices.size(), -1);       // reset the flooding values
+
+    planeNeighbours.clear();
+    planeNeighbours.resize(cutPlanes.size()*2, -1);
+
+    for(unsigned int i=0; i<cutPlanes.size(); i++) markPlaneSides(i, intersectionTriangles[i]);
+}
+
+void MeshGeometry::markPlaneSides(unsigned int index, const std::vector<unsigned int> &intersectionTrianglesPlane){
+    for(unsigned int k=0; k<intersectionTrianglesPlane.size(); k++){
+        const unsigned int &i = intersectionTrianglesPlane[k];
+
+        // For each vertex, get the apporiate sign
+        for(unsigned int j=0; j<3; j++){
+            double sign = cutPlanes[index].getSign(toDouble(vertices[triangles[i].getVertex(j)]));     // get which side of the plane the vertex is on
+            if(sign >= 0 ){
+                flooding[triangles[i].getVertex(j)] = static_cast<int>(cutPlanes.size() + index);
+            }
+            else if(sign < 0){
+                flooding[triangles[i].getVertex(j)] =  static_cast<int>(index);
+            }
+        }
+    }
+}
+
+void MeshGeometry::floodFromIntersections(){
+    MEDMAX_TRACE("MeshGeometry::floodFromIntersections");
+    for(unsigned int i=0; i<intersectionTriangles.size(); i++){
+        std::vector<unsigned int> &triIndexes = intersectionTriangles[i];
+        for(unsigned int k=0; k<triIndexes.size(); k++){
+            for(unsigned int l=0; l<3; l++){
+                Triangle &t = triangles[triIndexes[k]];
+                unsigned int index = t.getVertex(l);
+                for(unsigned int j=0; j<oneRing[index].size(); j++){
+                    floodNeighbour(oneRing[index][j], flooding[index]);
+                }
+            }
+        }
+    }
+}
+
+void MeshGeometry::floodNeighbour(unsigned int index, int id){
+    const int nbPlanes = static_cast<int>(cutPlanes.size());
+    std::queue<unsigned int> toFlood;
+    toFlood.push(index);
+
+    while(toFlood.size()!=0){
+        index = toFlood.front();
+        int flood = flooding[index];
+        toFlood.pop();
+        if(flood == -1){      // Flood it
+            flooding[index] = id;
+            for(unsigned int i=0; i<oneRing[index].size(); i++){
+                toFlood.push(oneRing[index][i]);
+            }
+        }
+
+        else if(flood == id) continue;      // stop if the vertex is already flooded with the same value
+
+        else if(flood==id+nbPlanes || id==flood+nbPlanes) continue;     // stop if we've found our own neg/pos side
+
+        else{       // else it already belongs to a different plane
+            if(planeNeighbours[static_cast<unsigned int>(id)]== -1){       // They're not already neighbours
+                planeNeighbours[static_cast<unsigned int>(id)] = flooding[index];     // equal to the old value
+                planeNeighbours[static_cast<unsigned int>(flooding[index])] = id;
+            }
+        }
+    }
+}
+
+void MeshGeometry::mergeFlood(){
+    MEDMAX_TRACE("MeshGeometry::mergeFlood");
+    for(unsigned int i=0; i<flooding.size(); i++){
+        int flood = flooding[i];
+        if(flood != -1){
+            int neighbour = planeNeighbours[static_cast<unsigned int>(flood)];
+            if(neighbour != -1 && neighbour < flood){     // From the two neighbours, set them both to the lowest value
+                flooding[i] = neighbour;
+            }
+        }
+    }
+}
+
+void MeshGeometry::cutMesh(){
+    MEDMAX_TRACE("MeshGeometry::cutMesh");
+    trianglesCut.clear();
+
+    std::vector<bool> truthTriangles(triangles.size(), false);  // keeps a record of the triangles who are already added
+
+    switch (cuttingSide) {
+        case Side::INTERIOR:        // MANDIBLE
+            cutMandible(truthTriangles);
+        break;
+
+        case Side::EXTERIOR:        // FIBULA
+            cutFibula(truthTriangles);
+        break;
+    }
+
+    trianglesExtracted.clear();     // Store the rest of the triangles
+    for(unsigned int i=0; i<triangles.size(); i++){
+        if(!truthTriangles[i]) trianglesExtracted.push_back(i);
+    }
+
+    isTriangleKept.assign(triangles.size(), false);
+    for(unsigned int i=0; i<trianglesCut.size(); i++) isTriangleKept[trianglesCut[i]] = true;
+}
+
+void MeshGeometry::cutMandible(std::vector<bool> &truthTriangles){
+    for(unsigned int i=0; i<flooding.size(); i++){
+        int flood = flooding[i];
+        if(flood == -1) continue;
+        int neighbour = planeNeighbours[static_cast<unsigned int>(flood)];
+        if(neighbour ==-1){
+            saveTrianglesToKeep(truthTriangles, i);
+        }
+    }
+}
+
+void MeshGeometry::cutFibula(std::vector<bool> &truthTriangles){
+    for(unsigned int j=0; j<intersectionTriangles.size(); j++){
+        const std::vector<unsigned int> &v = intersectionTriangles[j];
+        for(unsigned int k=0; k<v.size(); k++) truthTriangles[v[k]] = true;
+    }
+
+    getSegmentsToKeep();    // figure out what to keep
+    for(unsigned int i=0; i<flooding.size(); i++){
+        bool isKeep = false;
+        for(unsigned int k=0; k<segmentsConserved.size(); k++){      // Only keep it if it belongs to a kept segment
+            if(segmentsConserved[k]==flooding[i]){
+                isKeep = true;
+                break;
+            }
+        }
+        if(isKeep) saveTrianglesToKeep(truthTriangles, i);
+    }
+}
+
+void MeshGeometry::saveTrianglesToKeep(std::vector<bool> &truthTriangles, unsigned int i){
+    for(unsigned int j=triangleRingStart[i]; j<triangleRingStart[i+1]; j++){        // Get the triangles the indicies belong to
+        if(!truthTriangles[triangleRing[j]]){     // If it's not already in the list
+            trianglesCut.push_back(triangleRing[j]);
+            truthTriangles[triangleRing[j]] = true;
+        }
+    }
+}
+
+void MeshGeometry::fillColours(std::vector <int> &coloursIndicies, const unsigned long long nbColours) const{
+    std::vector<int> tempColours(nbColours, -1);
+    coloursIndicies.clear();
+
+    for(unsigned int i=0; i<segmentsConserved.size(); i++) tempColours[static_cast<unsigned int>(segmentsConserved[i])] = static_cast<int>(i);       // change to the seg colours value
+
+    for(unsigned int i=0; i<vertices.size(); i++){
+        int index = flooding[i];
+        coloursIndicies.push_back(index != -1 ? tempColours[static_cast<unsigned int>(index)] : -1);      // Fill the colours
+    }
+}
+
+void MeshGeometry::exportSegments(SegmentTransfer &transfer) const{
+    MEDMAX_TRACE("MeshGeometry::exportSegments");
+    transfer = SegmentTransfer();
+    std::vector<int> convertedIndex(smoothedVerticies.size(), -1);     // a marker for already converted verticies
+
+    std::vector <int> coloursIndicies;
+    fillColours(coloursIndicies, cutPlanes.size()*2);
+
+    const int nbPlanes = static_cast<int>(cutPlanes.size());
+    for(unsigned int i=0; i<trianglesCut.size(); i++){      // For every triangle we want to send (we've already filtered out the rest when cutting the mesh)
+        unsigned int newTriangle[3];
+
+        for(unsigned int j=0; j<3; j++){
+            const unsigned int &triVert = triangles[trianglesCut[i]].getVertex(j);
+
+            if(convertedIndex[triVert] == -1){      // convert to the corresponding plane
+                int pNb = flooding[triVert];
+                if(pNb >= nbPlanes) pNb -= nbPlanes;      // The plane nb is referenced by the smallest side
+                const AffineFrame &frame = cutPlanes[static_cast<unsigned int>(pNb)].getFrame();
+
+                transfer.planeNb.push_back(pNb);
+                transfer.vertices.push_back(frame.localCoordinatesOf(toDouble(smoothedVerticies[triVert])));
+                transfer.normals.push_back(frame.localVectorOf(toDouble(getSmoothedNormals()[triVert])));
+                transfer.colours.push_back(coloursIndicies[triVert]);
+
+                convertedIndex[triVert] = static_cast<int>(transfer.vertices.size()) - 1;
+            }
+            newTriangle[j] = static_cast<unsigned int>(convertedIndex[triVert]);
+        }
+        transfer.triangles.push_back(Triangle(newTriangle));
+    }
+}
+
+// The same planes as the fibula's : 0 left, 1 right, then each pair of fibula ghost planes goes with one ghost plane
+void MeshGeometry::placeSegments(const SegmentTransfer &transfer, std::vector<Vec3Df> &placedVertices, std::vector<Vec3Df> &placedNormals) const{
+    placedVertices.resize(transfer.vertices.size());
+    placedNormals.resize(transfer.normals.size());
+
+    for(unsigned int i=0; i<transfer.vertices.size(); i++){
+        unsigned int mandPlane = static_cast<unsigned int>(transfer.planeNb[i]);
+        if(mandPlane > 1) mandPlane = mandPlane/2 + 1;
+        const AffineFrame &frame = cutPlanes[mandPlane].getFrame();
+
+        placedVertices[i] = toFloat(frame.worldCoordinatesOf(transfer.vertices[i]));
+        placedNormals[i] = toFloat(frame.worldVectorOf(transfer.normals[i]));
+    }
+}
+
+// WARNING : this assumes that the left and right planes are the first planes added!
+// Could search for the exterior planes beforehand using the fact that the other sides = -1
+void MeshGeometry::getSegmentsToKeep(){
+    segmentsConserved.clear();
+    const int nbPlanes = static_cast<int>(cutPlanes.size());
+
+    // Find the non-discarded side of the left plane
+    int planeToKeep;
+    if(planeNeighbours[0]!=-1) planeToKeep = 0; // if it has a neighbour
+    else planeToKeep = nbPlanes;   // keep the otherside if 0 is discared
+
+    // if there are no ghost planes
+    if(nbPlanes==2){
+        int rightPlaneKept;
+        if(planeNeighbours[1]!=-1) rightPlaneKept = 1;
+        else rightPlaneKept = 3;
+
+        // Keep the smallest
+        segmentsConserved.push_back(std::min(planeToKeep, rightPlaneKept));
+        return;
+    }
+
+    // while we haven't found the right plane
+    while(planeToKeep!=1 && planeToKeep!=nbPlanes+1){
+        int nextPlane = planeNeighbours[static_cast<unsigned int>(planeToKeep)];   // move on to the next plane
+
+        // Keep the smaller of the two values to match the merge flood
+        if(planeToKeep < nextPlane) segmentsConserved.push_back(planeToKeep);
+        else segmentsConserved.push_back(nextPlane);
+
+        // discard the other side
+        int toDiscard;
+        if( nextPlane < nbPlanes ) toDiscard = nextPlane + nbPlanes;
+        else toDiscard = nextPlane - nbPlanes;
+
+        if(toDiscard==1 || toDiscard==nbPlanes+1) break;
+
+        // move on to the next plane
+        nextPlane = planeNeighbours[static_cast<unsigned int>(toDiscard)];
+
+        // keep the other side
+        if( nextPlane < nbPlanes ) planeToKeep = nextPlane + nbPlanes;
+        else planeToKeep = nextPlane - nbPlanes;
+    }
+}
+
+void MeshGeometry::reportMemory(MemoryReport &report) const{
+    report.add("vertices", vertices);
+    report.add("triangles", triangles);
+    report.add("verticesNormals", verticesNormals);
+    report.add("triangleNormals", triangleNormals);
+    report.add("originalVertices", originalVertices);
+    report.add("originalTriangles", originalTriangles);
+    report.add("oneRing", oneRing);
+    report.add("triangleRingStart", triangleRingStart);
+    report.add("triangleRing", triangleRing);
+    slabIndex.reportMemory(report);
+    cutCache.reportMemory(report);
+    report.add("cutPlanes", cutPlanes);
+    report.add("intersectionTriangles", intersectionTriangles);
+    report.add("intersectionPlanes", intersectionPlanes);
+    report.add("flooding", flooding);
+    report.add("planeNeighbours", planeNeighbours);
+    report.add("trianglesCut", trianglesCut);
+    report.add("trianglesExtracted", trianglesExtracted);
+    report.add("segmentsConserved", segmentsConserved);
+    report.add("smoothedVerticies", smoothedVerticies);
+    report.add("smoothedNormals", smoothedNormals);
+    report.add("smoothedTriangleNormals", smoothedTriangleNormals);
+    report.add("smoothedMoved", smoothedMoved);
+    report.add("smoothedFaces", smoothedFaces);
+    report.add("smoothedTouched", smoothedTouched);
+}
+
+void MeshGeometry::createSmoothedTriangles(){
+    MEDMAX_TRACE("MeshGeometry::createSmoothedTriangles");
+    if(smoothedVerticies.size() != vertices.size()) smoothedVerticies = vertices;  // Copy the verticies table
+    else for(unsigned int i=0; i<smoothedMoved.size(); i++) smoothedVerticies[smoothedMoved[i]] = vertices[smoothedMoved[i]];      // or only put back the last cut
+    smoothedMoved.clear();
+
+    switch (cuttingSide) {
+        case Side::INTERIOR:
+            createSmoothedMandible();
+        break;
+
+        case Side::EXTERIOR:
+            createSmoothedFibula();
+        break;
+    }
+}
+
+// The same as recomputing all the normals of the smoothed mesh from the kept triangles, for the verticies around the cut only
+void MeshGeometry::updateSmoothedNormals(){
+    MEDMAX_TRACE("MeshGeometry::updateSmoothedNormals");
+    if(triangleNormals.size() != triangles.size()) return;      // no one rings, getSmoothedNormals gives the normals of the mesh
+
+    if(smoothedNormals.size() != vertices.size()){
+        smoothedNormals = verticesNormals;
+        smoothedTriangleNormals = triangleNormals;
+    }
+    else{
+        for(unsigned int i=0; i<smoothedFaces.size(); i++) smoothedTriangleNormals[smoothedFaces[i]] = triangleNormals[smoothedFaces[i]];
+        for(unsigned int i=0; i<smoothedTouched.size(); i++) smoothedNormals[smoothedTouched[i]] = verticesNormals[smoothedTouched[i]];
+    }
+
+    updateNormals(smoothedVerticies, smoothedMoved, isTriangleKept, smoothedTriangleNormals, smoothedNormals, smoothedFaces, smoothedTouched);
+}
+
+void MeshGeometry::createSmoothedMandible(){
+    for(unsigned int i=0; i<cutPlanes.size(); i++){
+        for(unsigned int j=0; j<intersectionTriangles[i].size(); j++){       // for each triangle cut
+            for(unsigned int k=0; k<3; k++){    // find which verticies to keep
+                const unsigned int &vertexIndex = triangles[intersectionTriangles[i][j]].getVertex(k);
+                if(flooding[vertexIndex] == -1) continue;       // never reached by the flooding
+                if(planeNeighbours[static_cast<unsigned int>(flooding[vertexIndex])] != -1){   // if we need to change it (here we only change it if it's outside of the cut (fine for mandible))
+                    smoothedVerticies[vertexIndex] = toFloat(cutPlanes[i].getProjection(toDouble(vertices[vertexIndex])));     // get the projection
+                    smoothedMoved.push_back(vertexIndex);
+                }
+                // else don't change the original
+            }
+        }
+    }
+}
+
+void MeshGeometry::createSmoothedFibula(){
+    for(unsigned int i=0; i<cutPlanes.size(); i++){
+        for(unsigned int j=0; j<intersectionTriangles[i].size(); j++){   // for each triangle cut
+            int actualFlooding = -1;    //  Conserve the "real" flooding value (will never stay at -1)
+
+            for(unsigned int k=0; k<3; k++){    // find which verticies are on the otherside of the cut
+                const unsigned int &vertexIndex = triangles[intersectionTriangles[i][j]].getVertex(k);
+
+                bool isOutlier = false;
+                for(unsigned int l=0; l<segmentsConserved.size(); l++){
+                    if(flooding[vertexIndex] == segmentsConserved[l]){
+                        actualFlooding = flooding[vertexIndex];
+                        isOutlier = true;
+                    }
+                }
+
+                if(flooding[vertexIndex] == -1) continue;       // already taken out with a triangle of another plane
+                if(planeNeighbours[static_cast<unsigned int>(flooding[vertexIndex])]==-1 || isOutlier){        // if we need to change it
+                    Vec3Dd newVertex;
+                    const unsigned int lastIndex = static_cast<unsigned int>(cutPlanes.size()-1);
+                    if(i>2 && i<lastIndex){
+                        if(i%2==0) newVertex = getPolylineProjectedVertex(i, i-1, vertexIndex);
+                        else newVertex = getPolylineProjectedVertex(i, i+1, vertexIndex);
+                    }
+                    else if(i==2) newVertex = getPolylineProjectedVertex(i, 0, vertexIndex);
+                    else if(i==lastIndex && lastIndex!=1) newVertex = getPolylineProjectedVertex(i, 1, vertexIndex);
+                    else if(i==0){
+                        if(lastIndex>1) newVertex = getPolylineProjectedVertex(i, 2, vertexIndex);
+                        else newVertex = getPolylineProjectedVertex(i, 1, vertexIndex);
+                    }
+                    else if(i==1){
+                        if(lastIndex>1) newVertex = getPolylineProjectedVertex(i, lastIndex, vertexIndex);
+                        else newVertex = getPolylineProjectedVertex(i, 0, vertexIndex);
+                    }
+                    smoothedVerticies[vertexIndex] = toFloat(newVertex); // get the projection
+                    smoothedMoved.push_back(vertexIndex);
+                }
+                // else don't change the original
+            }
+
+            // Set the whole triangle to the correct flooding value
+            for(unsigned int k=0; k<3; k++){
+                const unsigned int &vertexIndex = triangles[intersectionTriangles[i][j]].getVertex(k);
+                flooding[vertexIndex] = actualFlooding;
+            }
+        }
+    }
+}
+
+// Slide the vertex along the polyline between the planes p1 and p2 until it reaches p1
+Vec3Dd MeshGeometry::getPolylineProjectedVertex(unsigned int p1, unsigned int p2, unsigned int vertexIndex) const{
+    const AffineFrame &frame = cutPlanes[p1].getFrame();
+    Vec3Dd n = cutPlanes[p2].getPosition() - cutPlanes[p1].getPosition();
+    n.normalize();
+    n = frame.localVectorOf(n);
+    Vec3Dd p = frame.localCoordinatesOf(toDouble(vertices[vertexIndex]));
+    double alpha = p[2] / n[2];
+    Vec3Dd newVertex = p - alpha*n;
+    return frame.worldCoordinatesOf(newVertex);
+}
+
+std::vector<unsigned int> MeshGeometry::getVerticesOnPlane(const CutPlane &intersecting, const CutPlane &p) const{
+    std::vector<unsigned int> v;
+    std::vector<unsigned int> intersectionTrianglesPlane;
+    planeIntersection(intersecting, intersectionTrianglesPlane);
+
+    for(unsigned int i=0; i<intersectionTrianglesPlane.size(); i++){
+        for(unsigned int k=0; k<3; k++){
+            const unsigned int &triangleNb = intersectionTrianglesPlane[i];
+            const unsigned int &index = triangles[triangleNb].getVertex(k);
+            const double z = Vec3Dd::dotProduct(toDouble(smoothedVerticies[index]) - p.getPosition(), p.getNormal());
+            if(fabs(z) < 0.001){
+                if(std::find(v.begin(), v.end(), index) == v.end()) v.push_back(index);
+            }
+        }
+    }
+    return v;
+}
@@ -0,0 +1,164 @@
+#ifndef MESHGEOMETRY_H
+#define MESHGEOMETRY_H
+
+#include "Vec3D.h"
+#include "Triangle.h"
+#include "cutplane.h"
+#include "threadpool.h"
+#include "memoryreport.h"
+#include "compactmesh.h"
+#include "curvegeometry.h"
+#include "cutcache.h"
+#include "slabindex.h"
+#include <vector>
+
+enum Side {INTERIOR, EXTERIOR};
+
+/*
+ * A triangle mesh and the stages which cut it with a list of planes (no Qt or OpenGL, the Mesh in the viewers draws it).
+ * The planes are the left and right planes first, then the ghost planes.
+ *
+ *  intersectPlanes -> seedPlaneSides -> floodFromIntersections -> mergeFlood -> cutMesh -> createSmoothedTriangles -> updateSmoothedNormals
+ *
+ * Each vertex is flooded with the side of the plane it's on (index for the negative side, index + nbPlanes for the positive one).
+*/
+class MeshGeometry
+{
+public:
+    // The kept fibula triangles, each vertex in the frame of the plane on its side (what the fibula sends to the mandible)
+    struct SegmentTransfer{
+        std::vector<int> planeNb;       // the plane of each vertex
+        std::vector<Vec3Dd> vertices;
+        std::vector<Vec3Dd> normals;
+        std::vector<int> colours;
+        std::vector<Triangle> triangles;
+    };
+
+    MeshGeometry(){}
+    MeshGeometry(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles) : vertices(vertices), triangles(triangles){}
+    explicit MeshGeometry(const CompactMesh &packed){ packed.unpack(vertices, verticesNormals, triangles); }       // the normals come with it, the one rings don't
+
+    CompactMesh pack(bool isQuantised) const { return CompactMesh(vertices, verticesNormals, triangles, isQuantised); }        // the vertices, normals and triangles only
+    const unsigned int* getIndexData() const { return triangles.size()!=0 ? triangles[0].data() : nullptr; }      // the triangles as 3 indicies each, one after the other
+
+    // Right after loading, before collectOneRings : the current order is kept as the original one,
+    // unless isAgain (the mesh was already reordered and still holds the order it was loaded in)
+    void reorderForLocality(bool isAgain = false);
+    void getInOriginalOrder(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles) const;     // the mesh as it was loaded
+    const std::vector<unsigned int>& getOriginalVertexIndices() const { return originalVertices; }      // empty if not reordered
+
+    void collectOneRings();     // to call whenever the triangles change
+    void computeBB(Vec3Df &centre, float& radius) const;
+    void recomputeNormals();        // on the global pool
+    void recomputeNormals(ThreadPool &pool);        // each vertex gathers the normals of its triangles once the one rings are there
+    void updateNormals(const std::vector<unsigned int> &movedVertices);     // only the normals around the verticies which have moved since the last recomputeNormals
+
+    // The triangles near each sample of the curve, for the planes up to planeSize placed on it (after collectOneRings, build again if the verticies move)
+    void buildSlabIndex(const CurveGeometry &curve, double planeSize, ThreadPool &pool);
+    void updateSlabIndex(const CurveGeometry &curve, unsigned int start, unsigned int end, ThreadPool &pool);      // the samples [start, end) have moved
+    void clearSlabIndex(){ slabIndex.clear(); }
+    const SlabIndex& getSlabIndex() const { return slabIndex; }
+
+    std::vector<Vec3Df> &getVertices(){return vertices;}
+    const std::vector<Vec3Df> &getVertices()const {return vertices;}
+
+    std::vector<Triangle> &getTriangles(){return triangles;}
+    const std::vector<Triangle> &getTriangles()const {return triangles;}
+
+    const std::vector<Vec3Df>& getNormals() const { return verticesNormals; }
+    const std::vector<Vec3Df>& getTriangleNormals() const { return triangleNormals; }
+    const std::vector<Vec3Df>& getSmoothedVertices() const { return smoothedVerticies; }
+    const std::vector<Vec3Df>& getSmoothedNormals() const { return smoothedNormals.size()==vertices.size() ? smoothedNormals : verticesNormals; }
+    const std::vector<int>& getFlooding() const { return flooding; }
+    const std::vector<unsigned int>& getTrianglesCut() const { return trianglesCut; }
+    const std::vector<unsigned int>& getTrianglesExtracted() const { return trianglesExtracted; }
+    const std::vector<int>& getSegmentsConserved() const { return segmentsConserved; }
+
+    // Cutting stages (in order)
+    void setCutPlanes(const std::vector<CutPlane> &planes, Side side);
+    void intersectPlanes(ThreadPool &pool);     // only the planes which have moved since the last cut are tested again
+    void seedPlaneSides();
+    void floodFromIntersections();
+    void mergeFlood();      // merges the regions between the planes
+    void cutMesh();
+    void createSmoothedTriangles();
+    void updateSmoothedNormals();       // only around the verticies createSmoothedTriangles moved, from the kept triangles
+    void cut(const std::vector<CutPlane> &planes, Side side, ThreadPool &pool);        // all the stages one after the other, or the cut from the cache
+
+    // The cuts of the planes already cut, to put back instead of cutting again (off until it's given a size)
+    void setCutCacheSize(size_t maxBytes){ cutCache.setMaxBytes(maxBytes); }
+    const CutCache& getCutCache() const { return cutCache; }
+    bool restoreCut();      // after setCutPlanes : false if these planes aren't in the cache
+    void saveCut();     // after updateSmoothedNormals
+
+    std::vector<unsigned int> getVerticesOnPlane(const CutPlane &intersecting, const CutPlane &p) const;     // the smoothed verticies of the triangles cut by intersecting which lie on p
+    void fillColours(std::vector <int> &coloursIndicies, const unsigned long long nbColours) const;
+
+    void exportSegments(SegmentTransfer &transfer) const;       // only for the fibula mesh, after the cut
+    void placeSegments(const SegmentTransfer &transfer, std::vector<Vec3Df> &placedVertices, std::vector<Vec3Df> &placedNormals) const;      // only for the mandible mesh : from the fibula planes to the matching planes of this mesh
+
+    void reportMemory(MemoryReport &report) const;
+
+protected:
+    Vec3Df computeTriangleNormal(const std::vector<Vec3Df> &positions, unsigned int t) const;
+    void computeVerticesNormals(ThreadPool &pool);
+    // The triangle normals around moved (faces), then the normals of every vertex of those triangles (touched), for the verticies at positions.
+    // The verticies only add up the triangles isUsed keeps (all of them if it's empty).
+    void updateNormals(const std::vector<Vec3Df> &positions, const std::vector<unsigned int> &moved, const std::vector<bool> &isUsed, std::vector<Vec3Df> &faceNormals,
+                       std::vector<Vec3Df> &normals, std::vector<unsigned int> &faces, std::vector<unsigned int> &touched);
+    void clearCut();        // forget the cut and the saved intersections
+    void resetSmoothed();       // the smoothed overlay is copied again from the mesh at the next cut (and the cached cuts are dropped)
+
+    void planeIntersection(const CutPlane &plane, std::vector <unsigned int> &intersectionTrianglesPlane) const;
+    void markPlaneSides(unsigned int index, const std::vector <unsigned int> &intersectionTrianglesPlane);     // set the flooding value of the verticies on each side of the plane
+    void floodNeighbour(unsigned int index, int id);     // flood the neighbours of the vertex index with the value id
+
+    void cutMandible(std::vector<bool> &truthTriangles);
+    void cutFibula(std::vector<bool> &truthTriangles);
+    void saveTrianglesToKeep(std::vector<bool> &truthTriangles, unsigned int i);
+    void getSegmentsToKeep();   // Only for the fibula mesh (gets the segments between 2 planes that we want to keep)
+
+    void createSmoothedMandible();
+    void createSmoothedFibula();
+    Vec3Dd getPolylineProjectedVertex(unsigned int p1, unsigned int p2, unsigned int vertexIndex) const;
+
+    std::vector <Vec3Df> vertices;      // starting verticies
+    std::vector <Triangle> triangles;       // starting triangles
+    std::vector<Vec3Df> verticesNormals;
+    std::vector<Vec3Df> triangleNormals;        // empty until the one rings are there
+
+    std::vector<unsigned int> originalVertices;     // where each vertex and triangle was before reorderForLocality
+    std::vector<unsigned int> originalTriangles;
+
+    std::vector<std::vector<unsigned int>> oneRing;
+    std::vector<unsigned int> triangleRingStart;        // the triangles of vertex v are triangleRing[triangleRingStart[v]] up to triangleRing[triangleRingStart[v+1]]
+    std::vector<unsigned int> triangleRing;
+
+    SlabIndex slabIndex;        // empty until there's a curve
+
+    std::vector<CutPlane> cutPlanes;
+    Side cuttingSide = Side::INTERIOR;
+
+    std::vector<std::vector<unsigned int>> intersectionTriangles;       // the triangles cut by each plane
+    std::vector<CutPlane> intersectionPlanes;     // where each plane was when its intersections were calculated
+    std::vector<int> flooding;
+    std::vector<int> planeNeighbours;
+
+    std::vector<unsigned int> trianglesCut;     // The list of triangles after the cutting (a list of triangle indicies)
+    std::vector<unsigned int> trianglesExtracted;       // The list of triangles taken out (the complement of trianglesCut)
+    std::vector<bool> isTriangleKept;       // the triangles in trianglesCut
+    std::vector<int> segmentsConserved; // filled with flooding values to keep
+
+    // The smoothed overlay : the mesh once cut, only what the last cut changed differs from the mesh, and is put back before the next one
+    std::vector<Vec3Df> smoothedVerticies;      // New verticies which line up with the cutting plane
+    std::vector<Vec3Df> smoothedNormals;
+    std::vector<Vec3Df> smoothedTriangleNormals;
+    std::vector<unsigned int> smoothedMoved;        // the verticies moved onto the planes (some more than once)
+    std::vector<unsigned int> smoothedFaces;        // the triangles around them
+    std::vector<unsigned int> smoothedTouched;      // and the verticies of those triangles
+    std::vector<bool> isFaceMarked, isVertexMarked;     // for updateNormals, all false in between
+
+    CutCache cutCache;
+};
+
+#endif // MESHGEOMETRY_H
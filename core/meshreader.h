@@ -0,0 +1,306 @@
+#ifndef MESHREADER_H
+#define MESHREADER_H
+
+#include <vector>
+#include <cstdlib>
+#include <stdio.h>
+#include <string>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cctype>
+#include <cstdint>
+
+namespace FileIO{
+
+    // Only triangles and quads (split in two) are handled. On a bad file the mesh is left empty and false is returned
+    template <typename Point, typename Face>
+    bool readOFF( std::string const &filename, std::vector<Point> &vertices, std::vector<Face> &triangles)
+    {
+        std::cout << "Opening " << filename << std::endl;
+
+        vertices.clear();
+        triangles.clear();
+
+        // open the file
+        std::ifstream myfile;
+        myfile.open(filename.c_str());
+        if (!myfile.is_open())
+        {
+            std::cout << filename << " cannot be opened" << std::endl;
+            return false;
+        }
+
+        std::string magic_s;
+
+        myfile >> magic_s;
+
+        // check if it's OFF
+        if( magic_s != "OFF" )
+        {
+            std::cout << magic_s << " != OFF :   We handle ONLY *.off files." << std::endl;
+            return false;
+        }
+
+        long long n_vertices , n_faces , dummy_int;
+        myfile >> n_vertices >> n_faces >> dummy_int;
+        if( !myfile || n_vertices < 0 || n_faces < 0 )
+        {
+            std::cout << filename << " : the header doesn't hold the counts" << std::endl;
+            return false;
+        }
+
+        // Read the verticies
+        for( long long v = 0 ; v < n_vertices && myfile ; ++v )
+        {
+            float x , y , z;
+            myfile >> x >> y >> z ;
+            vertices.push_back( Point( x , y , z ) );
+        }
+
+        // Read the triangles
+        bool isValid = true;
+        for( long long f = 0 ; f < n_faces && myfile && isValid ; ++f )
+        {
+            int n_vertices_on_face;
+            myfile >> n_vertices_on_face;
+            if( n_vertices_on_face != 3 && n_vertices_on_face != 4 )
+            {
+                std::cout << "We handle ONLY *.off files with 3 or 4 vertices per face" << std::endl;
+                isValid = false;
+                break;
+            }
+
+            unsigned int _v[4];
+            for( int k = 0 ; k < n_vertices_on_face ; ++k )
+            {
+                myfile >> _v[k];
+                if( myfile && _v[k] >= vertices.size() )
+                {
+                    std::cout << filename << " : face " << f << " uses the vertex " << _v[k] << " of " << vertices.size() << std::endl;
+                    isValid = false;
+                }
+            }
+            if( !isValid ) break;
+
+            triangles.push_back( Face(_v[0], _v[1], _v[2]) );
+            if( n_vertices_on_face == 4 ) triangles.push_back( Face(_v[0], _v[2], _v[3]) );
+        }
+
+        if( isValid && !myfile )
+        {
+            std::cout << filename << " is too short" << std::endl;
+            isValid = false;
+        }
+        if( !isValid )
+        {
+            vertices.clear();
+            triangles.clear();
+        }
+        return isValid;
+    }
+
+    // Like readOFF, but a bad file ends the program (one which can't be opened only leaves the mesh empty)
+    template <typename Point, typename Face>
+    void openOFF( std::string const &filename, std::vector<Point> &vertices, std::vector<Face> &triangles)
+    {
+        if( !readOFF(filename, vertices, triangles) && std::ifstream(filename.c_str()).is_open() ) exit(1);
+    }
+
+    template <typename Point, typename Face>
+    bool saveOFF( std::string const &filename, std::vector<Point> const &vertices, std::vector<Face> const &triangles)
+    {
+        std::ofstream myfile;
+        myfile.open(filename.c_str());
+        if (!myfile.is_open())
+        {
+            std::cout << filename << " cannot be opened" << std::endl;
+            return false;
+        }
+
+        myfile << "OFF" << std::endl;
+        myfile << vertices.size() << " " << triangles.size() << " 0" << std::endl;
+
+        for( unsigned int v = 0 ; v < vertices.size() ; ++v )
+            myfile << vertices[v][0] << " " << vertices[v][1] << " " << vertices[v][2] << "\n";
+
+        for( unsigned int f = 0 ; f < triangles.size() ; ++f )
+            myfile << "3 " << triangles[f].getVertex(0) << " " << triangles[f].getVertex(1) << " " << triangles[f].getVertex(2) << "\n";
+
+        return myfile.good();
+    }
+
+    // Binary PLY, always little endian whatever the machine (floats for the verticies, int indicies for the triangles)
+    inline void writeLittleEndian(char *bytes, uint32_t value)
+    {
+        for( int i = 0 ; i < 4 ; ++i ) bytes[i] = static_cast<char>((value >> (8*i)) & 0xff);
+    }
+
+    inline uint32_t readLittleEndian(const char *bytes)
+    {
+        uint32_t value = 0;
+        for( int i = 0 ; i < 4 ; ++i ) value |= static_cast<uint32_t>(static_cast<unsigned char>(bytes[i])) << (8*i);
+        return value;
+    }
+
+    template <typename Point, typename Face>
+    bool savePLY( std::string const &filename, std::vector<Point> const &vertices, std::vector<Face> const &triangles)
+    {
+        std::ofstream myfile;
+        myfile.open(filename.c_str(), std::ios::binary);
+        if (!myfile.is_open())
+        {
+            std::cout << filename << " cannot be opened" << std::endl;
+            return false;
+        }
+
+        myfile << "ply\n" << "format binary_little_endian 1.0\n"
+               << "element vertex " << vertices.size() << "\n"
+               << "property float x\n" << "property float y\n" << "property float z\n"
+               << "element face " << triangles.size() << "\n"
+               << "property list uchar int vertex_indices\n"
+               << "end_header\n";
+
+        char bytes[13];
+        for( unsigned int v = 0 ; v < vertices.size() ; ++v )
+        {
+            for( int c = 0 ; c < 3 ; ++c )
+            {
+                float x = vertices[v][c];
+                uint32_t bits;
+                memcpy(&bits, &x, 4);
+                writeLittleEndian(bytes + 4*c, bits);
+            }
+            myfile.write(bytes, 12);
+        }
+
+        bytes[0] = 3;
+        for( unsigned int f = 0 ; f < triangles.size() ; ++f )
+        {
+            for( unsigned int c = 0 ; c < 3 ; ++c ) writeLittleEndian(bytes + 1 + 4*c, triangles[f].getVertex(c));
+            myfile.write(bytes, 13);
+        }
+
+        return myfile.good();
+    }
+
+    // Only reads the files written by savePLY (binary little endian, float x y z, triangles)
+    template <typename Point, typename Face>
+    bool openPLY( std::string const &filename, std::vector<Point> &vertices, std::vector<Face> &triangles)
+    {
+        std::cout << "Opening " << filename << std::endl;
+
+        std::ifstream myfile;
+        myfile.open(filename.c_str(), std::ios::binary);
+        if (!myfile.is_open())
+        {
+            std::cout << filename << " cannot be opened" << std::endl;
+            return false;
+        }
+
+        // The header has to be exactly the one savePLY writes, apart from the sizes
+        const char *expected[] = { "ply", "format binary_little_endian 1.0", "element vertex", "property float x", "property float y", "property float z",
+                                   "element face", "property list uchar int vertex_indices", "end_header" };
+        unsigned long long n_vertices = 0 , n_faces = 0;
+        std::string line;
+        for( unsigned int i = 0 ; i < 9 ; ++i )
+        {
+            do { std::getline(myfile, line); } while( myfile && line.compare(0, 7, "comment") == 0 );
+            if( line.compare(0, strlen(expected[i]), expected[i]) != 0 )
+            {
+                std::cout << filename << " : only binary little endian PLY triangle meshes (as written by savePLY) are handled" << std::endl;
+                return false;
+            }
+            if( i == 2 ) n_vertices = std::strtoull(line.c_str() + strlen(expected[i]), nullptr, 10);
+            if( i == 6 ) n_faces = std::strtoull(line.c_str() + strlen(expected[i]), nullptr, 10);
+        }
+
+        std::vector<char> bytes(n_vertices * 12);
+        myfile.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+        vertices.clear();
+        vertices.reserve(n_vertices);
+        for( unsigned long long v = 0 ; v < n_vertices ; ++v )
+        {
+            float p[3];
+            for( int c = 0 ; c < 3 ; ++c )
+            {
+                uint32_t bits = readLittleEndian(bytes.data() + 12*v + 4*c);
+                memcpy(&p[c], &bits, 4);
+            }
+            vertices.push_back( Point( p[0] , p[1] , p[2] ) );
+        }
+
+        bytes.assign(n_faces * 13, 0);
+        myfile.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+        triangles.clear();
+        triangles.reserve(n_faces);
+        for( unsigned long long f = 0 ; f < n_faces ; ++f )
+        {
+            const char *face = bytes.data() + 13*f;
+            if( face[0] != 3 )
+            {
+                std::cout << filename << " : only triangles are handled" << std::endl;
+                return false;
+            }
+            triangles.push_back( Face( readLittleEndian(face + 1) , readLittleEndian(face + 5) , readLittleEndian(face + 9) ) );
+        }
+
+        if( !myfile )
+        {
+            std::cout << filename << " is too short" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Picks the reader from the extension (.ply or .off)
+    template <typename Point, typename Face>
+    bool openMesh( std::string const &filename, std::vector<Point> &vertices, std::vector<Face> &triangles)
+    {
+        if( filename.size() >= 4 && filename.compare(filename.size()-4, 4, ".ply") == 0 ) return openPLY(filename, vertices, triangles);
+        return readOFF(filename, vertices, triangles);
+    }
+}
+
+namespace MeshTools{
+    template <typename Point>
+    void computeAveragePosAndRadius ( const std::vector<Point> & points, Point & center, double & radius){
+        center = Point (0.0, 0.0, 0.0);
+        for (unsigned int i = 0; i < points.size (); i++)
+            center += points[i];
+        center /= float (points.size ());
+        radius = 0.0;
+        for (unsigned int i = 0; i < points.size (); i++) {
+            float vDistance = (points[i] - center).norm();
+            if (static_cast<double>(vDistance) > radius)
+                radius = static_cast<double>(vDistance);
+        }
+    }
+
+    template <typename Point>
+    void scaleAndCenterToUnitBox ( std::vector<Point> & points, Point & center, double & scale ){
+        computeAveragePosAndRadius (points, center, scale);
+        for (unsigned int i = 0; i < points.size (); i++){
+            points[i] = (points[i] - center)/ scale;
+        }
+
+    }
+
+    template <typename Point>
+    bool isVisiblePoint( const Point & p, const Point & clippingNormal, const Point & pointOnClipping ){
+        Point pos = p - pointOnClipping;
+        float dotProduct = 0.;
+        for(int v = 0 ; v < 3; v ++)
+            dotProduct += clippingNormal[v]*pos[v];
+
+        if( static_cast<double>(dotProduct) < 0.) return false;
+
+        return true;
+    }
+
+}
+
+#endif // MESHREADER_H
@@ -0,0 +1,143 @@
+#include "meshreorder.h"
+#include "vec3kernels.h"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+
+// The 10 low bits of x spread out to every third bit
+static uint32_t spreadBits(uint32_t x){
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+std::vector<unsigned int> MeshReorder::mortonOrder(const std::vector<Vec3Df> &vertices){
+    Vec3Df bbMin, bbMax;
+    Vec3Kernels::boundingBox(vertices, bbMin, bbMax);
+
+    Vec3Df scale;
+    for(int k=0; k<3; k++) scale[k] = bbMax[k] > bbMin[k] ? 1023.f / (bbMax[k] - bbMin[k]) : 0.f;
+
+    std::vector<std::pair<uint32_t, unsigned int>> codes(vertices.size());
+    for(unsigned int i=0; i<vertices.size(); i++){
+        uint32_t code = 0;
+        for(int k=0; k<3; k++) code |= spreadBits(static_cast<uint32_t>((vertices[i][k] - bbMin[k]) * scale[k])) << k;
+        codes[i] = std::make_pair(code, i);
+    }
+    std::sort(codes.begin(), codes.end());      // the same code keeps the file order
+
+    std::vector<unsigned int> order(vertices.size());
+    for(unsigned int i=0; i<codes.size(); i++) order[i] = codes[i].second;
+    return order;
+}
+
+/*
+ * Fans around one vertex at a time, emitting all its remaining triangles, then moves on to the vertex of the
+ * last fan which is still in the cache and has the most triangles left. When none is, it goes back to the most recent
+ * vertex with triangles left (the dead end stack), then to the next one in index order.
+*/
+std::vector<unsigned int> MeshReorder::tipsifyOrder(const std::vector<Triangle> &triangles, unsigned int nbVertices, unsigned int cacheSize){
+    const unsigned int nbTriangles = static_cast<unsigned int>(triangles.size());
+
+    // The triangles of each vertex, one after the other
+    std::vector<unsigned int> start(nbVertices + 1, 0);
+    for(unsigned int t=0; t<nbTriangles; t++) for(unsigned int j=0; j<3; j++) start[triangles[t].getVertex(j) + 1]++;
+    for(unsigned int v=0; v<nbVertices; v++) start[v+1] += start[v];
+    std::vector<unsigned int> adjacent(start[nbVertices]);
+    std::vector<unsigned int> fill(start.begin(), start.end()-1);
+    for(unsigned int t=0; t<nbTriangles; t++) for(unsigned int j=0; j<3; j++) adjacent[fill[triangles[t].getVertex(j)]++] = t;
+
+    std::vector<unsigned int> nbLive(nbVertices);
+    for(unsigned int v=0; v<nbVertices; v++) nbLive[v] = start[v+1] - start[v];
+
+    std::vector<unsigned int> cacheTime(nbVertices, 0);
+    std::vector<bool> isEmitted(nbTriangles, false);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> order;
+    order.reserve(nbTriangles);
+
+    unsigned int time = cacheSize + 1;
+    unsigned int cursor = 0;
+    int fanning = nbVertices!=0 ? 0 : -1;
+
+    while(fanning >= 0){
+        const unsigned int f = static_cast<unsigned int>(fanning);
+        candidates.clear();
+        for(unsigned int a=start[f]; a<start[f+1]; a++){
+            const unsigned int t = adjacent[a];
+            if(isEmitted[t]) continue;
+            isEmitted[t] = true;
+            order.push_back(t);
+            for(unsigned int j=0; j<3; j++){
+                const unsigned int v = triangles[t].getVertex(j);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                nbLive[v]--;
+                if(time - cacheTime[v] > cacheSize){
+                    cacheTime[v] = time;
+                    time++;
+                }
+            }
+        }
+
+        // The candidate which will still be in the cache after its remaining triangles, and has been there longest
+        fanning = -1;
+        int best = -1;
+        for(unsigned int c=0; c<candidates.size(); c++){
+            const unsigned int v = candidates[c];
+            if(nbLive[v] == 0) continue;
+            int priority = 0;
+            if(time - cacheTime[v] + 2*nbLive[v] <= cacheSize) priority = static_cast<int>(time - cacheTime[v]);
+            if(priority > best){
+                best = priority;
+                fanning = static_cast<int>(v);
+            }
+        }
+
+        if(fanning < 0){
+            while(!deadEnds.empty() && fanning < 0){
+                const unsigned int d = deadEnds.back();
+                deadEnds.pop_back();
+                if(nbLive[d] > 0) fanning = static_cast<int>(d);
+            }
+            while(fanning < 0 && cursor < nbVertices){
+                if(nbLive[cursor] > 0) fanning = static_cast<int>(cursor);
+                cursor++;
+            }
+        }
+    }
+
+    return order;
+}
+
+double MeshReorder::getACMR(const std::vector<Triangle> &triangles, unsigned int nbVertices, unsigned int cacheSize){
+    if(triangles.size()==0) return 0;
+
+    std::vector<bool> isCached(nbVertices, false);
+    std::deque<unsigned int> cache;
+    unsigned long long nbMisses = 0;
+    for(unsigned int t=0; t<triangles.size(); t++){
+        for(unsigned int j=0; j<3; j++){
+            const unsigned int v = triangles[t].getVertex(j);
+            if(isCached[v]) continue;
+            nbMisses++;
+            cache.push_back(v);
+            isCached[v] = true;
+            if(cache.size() > cacheSize){
+                isCached[cache.front()] = false;
+                cache.pop_front();
+            }
+        }
+    }
+    return static_cast<double>(nbMisses) / static_cast<double>(triangles.size());
+}
+
+std::vector<unsigned int> MeshReorder::invert(const std::vector<unsigned int> &order){
+    std::vector<unsigned int> inverse(order.size());
+    for(unsigned int i=0; i<order.size(); i++) inverse[order[i]] = i;
+    return inverse;
+}
@@ -0,0 +1,27 @@
+#ifndef MESHREORDER_H
+#define MESHREORDER_H
+
+#include "Vec3D.h"
+#include "Triangle.h"
+#include <vector>
+
+/*
+ * Orders to lay a mesh out in memory so that neighbours are close : the scanners write the verticies and triangles
+ * in whatever order they were acquired, and the flooding, the plane tests and the drawing then jump all over memory.
+ * Each order is a permutation, order[new index] = old index.
+*/
+namespace MeshReorder{
+    // The verticies sorted along a Morton (Z-order) curve over their bounding box, 10 bits per axis
+    std::vector<unsigned int> mortonOrder(const std::vector<Vec3Df> &vertices);
+
+    // The triangles in the order of Tipsify (Sander, Nehab and Barczak 2007) for a vertex cache of cacheSize entries
+    std::vector<unsigned int> tipsifyOrder(const std::vector<Triangle> &triangles, unsigned int nbVertices, unsigned int cacheSize = 16);
+
+    // The average cache miss ratio (misses per triangle, 0.5 at best and 3 at worst) of a FIFO vertex cache drawing the triangles
+    double getACMR(const std::vector<Triangle> &triangles, unsigned int nbVertices, unsigned int cacheSize = 16);
+
+    // The inverse of order (inverse[old index] = new index)
+    std::vector<unsigned int> invert(const std::vector<unsigned int> &order);
+}
+
+#endif // MESHREORDER_H
@@ -0,0 +1,124 @@
+#include "perfcounters.h"
+#include <atomic>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static std::atomic<bool> isCounting(false);
+
+PerfSample& PerfSample::operator+=(const PerfSample &s){
+    if(!s.isValid) return *this;
+    isValid = true;
+    cycles += s.cycles;
+    instructions += s.instructions;
+    cacheMisses += s.cacheMisses;
+    branchMisses += s.branchMisses;
+    return *this;
+}
+
+void PerfCounters::setEnabled(bool isEnabled){
+    isCounting = isEnabled;
+}
+
+bool PerfCounters::isEnabled(){
+    return isCounting;
+}
+
+PerfCounters& PerfCounters::forThread(){
+    thread_local PerfCounters counters;
+    return counters;
+}
+
+#ifdef __linux__
+
+static int openCounter(uint64_t config, int group){
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group == -1 ? 1 : 0;        // the whole group starts with the leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));       // this thread, any cpu
+}
+
+PerfCounters::PerfCounters(){
+    const uint64_t configs[nbCounters] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for(int i=0; i<nbCounters; i++) fds[i] = -1;
+
+    for(int i=0; i<nbCounters; i++){
+        fds[i] = openCounter(configs[i], i==0 ? -1 : fds[0]);
+        if(fds[i] < 0){
+            for(int j=0; j<i; j++) close(fds[j]);
+            return;
+        }
+    }
+    leader = fds[0];
+}
+
+PerfCounters::~PerfCounters(){
+    if(leader < 0) return;
+    for(int i=0; i<nbCounters; i++) close(fds[i]);
+}
+
+bool PerfCounters::readGroup(uint64_t values[nbValues]) const{
+    return read(leader, values, nbValues * sizeof(uint64_t)) == static_cast<ssize_t>(nbValues * sizeof(uint64_t)) && values[0] == nbCounters;
+}
+
+// Only the outermost measure turns the group on and off, the nested ones just read it
+void PerfCounters::start(){
+    if(leader < 0) return;
+    if(frames.empty()) ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    frames.push_back(Frame());
+    frames.back().isRead = readGroup(frames.back().values);
+}
+
+static uint64_t withoutNested(uint64_t count, uint64_t nested){
+    return count > nested ? count - nested : 0;
+}
+
+PerfSample PerfCounters::stop(){
+    PerfSample sample;
+    if(leader < 0 || frames.empty()) return sample;
+
+    uint64_t values[nbValues];
+    const bool isRead = readGroup(values);
+    const Frame frame = frames.back();
+    frames.pop_back();
+    if(frames.empty()) ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if(!isRead || !frame.isRead) return sample;
+
+    // Multiplexed : extrapolate from the time the group was actually counting
+    const uint64_t enabled = values[1] - frame.values[1];
+    const uint64_t running = values[2] - frame.values[2];
+    const double scale = running!=0 ? static_cast<double>(enabled) / static_cast<double>(running) : 0;
+    if(scale == 0) return sample;
+
+    sample.isValid = true;
+    sample.cycles = static_cast<uint64_t>(static_cast<double>(values[3] - frame.values[3]) * scale);
+    sample.instructions = static_cast<uint64_t>(static_cast<double>(values[4] - frame.values[4]) * scale);
+    sample.cacheMisses = static_cast<uint64_t>(static_cast<double>(values[5] - frame.values[5]) * scale);
+    sample.branchMisses = static_cast<uint64_t>(static_cast<double>(values[6] - frame.values[6]) * scale);
+    if(!frames.empty()) frames.back().nested += sample;     // all of it, the measures it holds included
+
+    sample.cycles = withoutNested(sample.cycles, frame.nested.cycles);
+    sample.instructions = withoutNested(sample.instructions, frame.nested.instructions);
+    sample.cacheMisses = withoutNested(sample.cacheMisses, frame.nested.cacheMisses);
+    sample.branchMisses = withoutNested(sample.branchMisses, frame.nested.branchMisses);
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters(){}
+PerfCounters::~PerfCounters(){}
+void PerfCounters::start(){}
+PerfSample PerfCounters::stop(){ return PerfSample(); }
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstdint>
+#include <vector>
+
+// Hardware counts over a stretch of code, scaled when the kernel had to multiplex the counters
+struct PerfSample{
+    bool isValid = false;       // false where the counters can't be opened (not Linux, perf_event_paranoid, a VM without a PMU)
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheMisses = 0;       // last level cache
+    uint64_t branchMisses = 0;
+
+    double getIPC() const { return cycles!=0 ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0; }
+    double getCacheMPKI() const { return instructions!=0 ? 1000. * static_cast<double>(cacheMisses) / static_cast<double>(instructions) : 0; }     // misses per 1000 instructions
+    double getBranchMPKI() const { return instructions!=0 ? 1000. * static_cast<double>(branchMisses) / static_cast<double>(instructions) : 0; }
+
+    PerfSample& operator+=(const PerfSample &s);
+};
+
+/*
+ * A perf_event_open group (cycles, instructions, LLC misses, branch misses) counting the calling thread only, in user space.
+ * Off until setEnabled(true) : each thread opens its group the first time it measures, start/stop are then a read (and an ioctl
+ * for the outermost ones). Measures nest : the group is read at start and at stop, and what a nested measure counted is left
+ * out of the one around it, as the pool runs other stages inline while it waits.
+ * The stages which use the pool only count the work done on the thread which started them.
+*/
+class PerfCounters
+{
+public:
+    static void setEnabled(bool isEnabled);
+    static bool isEnabled();
+
+    // Counts f on the calling thread, the sample isn't valid while disabled or when the counters can't be opened
+    template<typename F> static PerfSample measure(F f){
+        if(!isEnabled()){
+            f();
+            return PerfSample();
+        }
+        PerfCounters &counters = forThread();
+        counters.start();
+        f();
+        return counters.stop();
+    }
+
+    static PerfCounters& forThread();
+
+    bool isAvailable() const { return leader >= 0; }
+    void start();
+    PerfSample stop();
+
+private:
+    PerfCounters();
+    ~PerfCounters();
+
+    static const int nbCounters = 4;
+    static const int nbValues = 3 + nbCounters;      // nr, time enabled, time running, then the counts
+
+    // A measure in progress : the group when it started, and what the measures inside it counted
+    struct Frame{
+        bool isRead = false;
+        uint64_t values[nbValues];
+        PerfSample nested;
+    };
+
+    bool readGroup(uint64_t values[nbValues]) const;
+
+    int leader = -1;
+    int fds[nbCounters];
+    std::vector<Frame> frames;      // the outermost first
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,144 @@
+#include "piececountevaluator.h"
+#include "fibulaplanning.h"
+#include "planoptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+typedef std::chrono::steady_clock Clock;
+
+PieceCountEvaluator::PieceCountEvaluator(const CurveGeometry &mandible, unsigned int leftIndex, unsigned int rightIndex, const CurveGeometry &fibula, unsigned int fibulaIndex, const std::vector<Vec3Df> &fibulaVertices, double constraint, double securityMargin, bool isOptimise)
+    : mandible(mandible), leftIndex(leftIndex), rightIndex(rightIndex), fibula(fibula), fibulaIndex(fibulaIndex), fibulaVertices(fibulaVertices), constraint(constraint), securityMargin(securityMargin), isOptimise(isOptimise){}
+
+std::vector<PieceCountEvaluator::PlanSummary> PieceCountEvaluator::evaluate(unsigned int maxPieces, ThreadPool &pool){
+    std::vector<PlanSummary> summaries(maxPieces);
+    pool.parallelFor(0, maxPieces, [&](unsigned int i){
+        summaries[i] = evaluatePlan(i+1, pool);
+    });
+    return summaries;
+}
+
+void PieceCountEvaluator::rank(std::vector<PlanSummary> &summaries){
+    std::stable_sort(summaries.begin(), summaries.end(), [](const PlanSummary &a, const PlanSummary &b){
+        const bool isCompleteA = a.isOnFibula && a.nbPlaced == a.nbPieces;
+        const bool isCompleteB = b.isOnFibula && b.nbPlaced == b.nbPieces;
+        if(isCompleteA != isCompleteB) return isCompleteA;
+        return a.rmsDeviation < b.rmsDeviation;
+    });
+}
+
+// The same steps as cutting : place the ghost planes, send the distances to the fibula, then bring the fibula planes together
+PieceCountEvaluator::PlanSummary PieceCountEvaluator::evaluatePlan(unsigned int nbPieces, ThreadPool &pool){
+    std::vector<unsigned int> plan, fibulaPlan;
+    return evaluatePlan(nbPieces, pool, plan, fibulaPlan);
+}
+
+PieceCountEvaluator::PlanSummary PieceCountEvaluator::evaluatePlan(unsigned int nbPieces, ThreadPool &pool, std::vector<unsigned int> &plan, std::vector<unsigned int> &fibulaPlan){
+    const Clock::time_point t0 = Clock::now();
+
+    PlanSummary s;
+    s.nbPieces = nbPieces;
+
+    // Mandible
+    std::vector<unsigned int> ghosts;
+    const unsigned int startI = mandible.indexForLength(leftIndex, constraint);
+    const unsigned int endI = mandible.indexForLength(rightIndex, -constraint);
+    if(nbPieces > 1) ghosts = PlanOptimizer::greedyPlan(mandible, startI, endI, nbPieces-1, constraint);
+
+    PlanOptimizer optimizer(mandible, constraint);
+    if(isOptimise && ghosts.size()!=0) ghosts = optimizer.optimise(leftIndex, rightIndex, ghosts, pool);
+    s.nbPlaced = static_cast<unsigned int>(ghosts.size()) + 1;
+
+    plan.clear();
+    plan.push_back(leftIndex);
+    plan.insert(plan.end(), ghosts.begin(), ghosts.end());
+    plan.push_back(rightIndex);
+
+    const double length = mandible.lengthAtIndex(rightIndex) - mandible.lengthAtIndex(leftIndex);
+    s.rmsDeviation = length > 0 ? sqrt(optimizer.getCost(plan) / length) : 0;
+    s.maxDeviation = 0;
+    for(unsigned int i=1; i<plan.size(); i++) s.maxDeviation = std::max(s.maxDeviation, maxChordDeviation(plan[i-1], plan[i]));
+
+    // Fibula : each piece is followed by the security margin
+    std::vector<double> distances;
+    for(unsigned int i=1; i<plan.size(); i++){
+        if(i!=1) distances.push_back(securityMargin);
+        distances.push_back(mandible.discreteLength(plan[i-1], plan[i]));
+    }
+
+    auto findIndexes = [&](std::vector<unsigned int> &indexes){
+        indexes.clear();
+        indexes.push_back(fibulaIndex);
+        s.isOnFibula = true;
+        for(unsigned int i=0; i<distances.size(); i++){
+            const unsigned int index = fibula.indexForLength(indexes.back(), distances[i]);
+            if(index == fibula.getNbU()-1 && fibula.discreteLength(indexes.back(), index) < distances[i] - 1.0) s.isOnFibula = false;     // ran out of bone
+            indexes.push_back(index);
+        }
+    };
+
+    findIndexes(fibulaPlan);
+
+    // Bring each pair of ghost planes together (the same thing as approachPlanes, without the mesh intersections)
+    s.approachShift = 0;
+    for(unsigned int i=1; i+1<fibulaPlan.size()-1; i+=2){
+        const double shift = std::min(approachShift(fibulaPlan[i], fibulaPlan[i+1]), distances[i]);
+        distances[i] -= shift;
+        s.approachShift += shift;
+    }
+    if(s.approachShift > 0) findIndexes(fibulaPlan);
+
+    s.fibulaLength = fibula.lengthAtIndex(fibulaPlan.back()) - fibula.lengthAtIndex(fibulaPlan.front());
+    s.duration = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    return s;
+}
+
+double PieceCountEvaluator::maxChordDeviation(unsigned int a, unsigned int b){
+    const Vec3Dd &pa = mandible.getPoint(a);
+    Vec3Dd chord = mandible.getPoint(b) - pa;
+    chord.normalize();
+
+    double maxD = 0;
+    for(unsigned int i=a+1; i<b; i++){
+        Vec3Dd v = mandible.getPoint(i) - pa;
+        maxD = std::max(maxD, (v - Vec3Dd::dotProduct(v, chord)*chord).norm());
+    }
+    return maxD;
+}
+
+// The bone on the first plane reaches further than the plane's centre, so the gap to the second plane can be closed up to the security distance
+double PieceCountEvaluator::approachShift(unsigned int a, unsigned int b){
+    const Vec3Dd &pa = fibula.getPoint(a);
+    const Vec3Dd &pb = fibula.getPoint(b);
+    Vec3Dd chord = pb - pa;
+    if(chord.norm() == 0) return 0;
+    chord.normalize();
+
+    const Vec3Dd na = fibula.tangent(a);        // the planes follow the curve
+    const Vec3Dd nb = fibula.tangent(b);
+
+    double maxA = -DBL_MAX;     // the furthest point on the first plane towards the second
+    double minB = DBL_MAX;      // the closest point on the second plane
+    for(unsigned int i=0; i<fibulaVertices.size(); i++){
+        const Vec3Df &fv = fibulaVertices[i];
+        const Vec3Dd v(fv[0], fv[1], fv[2]);
+
+        const double along = Vec3Dd::dotProduct(v - pa, chord);
+
+        Vec3Dd va = v - pa;
+        const double ha = Vec3Dd::dotProduct(va, na);
+        if(fabs(ha) < planeThickness && (va - ha*na).norm() < FibulaPlanning::ghostPlaneSize) maxA = std::max(maxA, along);
+
+        Vec3Dd vb = v - pb;
+        const double hb = Vec3Dd::dotProduct(vb, nb);
+        if(fabs(hb) < planeThickness && (vb - hb*nb).norm() < FibulaPlanning::ghostPlaneSize) minB = std::min(minB, along);
+    }
+
+    if(maxA == -DBL_MAX || minB == DBL_MAX) return 0;       // no bone on one of the planes
+
+    double shift = minB - maxA;
+    if(shift > FibulaPlanning::approachSecurity) shift -= FibulaPlanning::approachSecurity;
+    else shift = 0;
+    return shift;
+}
@@ -0,0 +1,51 @@
+#ifndef PIECECOUNTEVALUATOR_H
+#define PIECECOUNTEVALUATOR_H
+
+#include "curvegeometry.h"
+#include "threadpool.h"
+#include "Vec3D.h"
+
+/*
+ * Runs the whole plan (ghost planes in the mandible, their distances on the fibula, approaching the planes)
+ * for every number of pieces without touching the viewers, so the numbers can be compared before cutting.
+ * The curves and the fibula verticies are only read, every number of pieces is evaluated in parallel.
+*/
+class PieceCountEvaluator
+{
+public:
+    struct PlanSummary{
+        unsigned int nbPieces;
+        unsigned int nbPlaced;          // the number of pieces which actually fit in the mandible
+        double rmsDeviation;            // from the mandible curve to the polyline (mm)
+        double maxDeviation;            // mm
+        double fibulaLength;            // how much of the fibula is used (mm)
+        double approachShift;           // how much the pieces were brought together on the fibula (mm)
+        double duration;                // ms
+        bool isOnFibula;                // false if the pieces run off the end of the fibula
+    };
+
+    PieceCountEvaluator(const CurveGeometry &mandible, unsigned int leftIndex, unsigned int rightIndex, const CurveGeometry &fibula, unsigned int fibulaIndex, const std::vector<Vec3Df> &fibulaVertices, double constraint, double securityMargin, bool isOptimise);
+
+    std::vector<PlanSummary> evaluate(unsigned int maxPieces, ThreadPool &pool);       // one summary per number of pieces (1 to maxPieces)
+    PlanSummary evaluatePlan(unsigned int nbPieces, ThreadPool &pool, std::vector<unsigned int> &plan, std::vector<unsigned int> &fibulaPlan);     // also returns the plane indexes in the mandible and the fibula
+    static void rank(std::vector<PlanSummary> &summaries);        // complete plans first, then the closest to the curve
+
+private:
+    PlanSummary evaluatePlan(unsigned int nbPieces, ThreadPool &pool);
+    double maxChordDeviation(unsigned int a, unsigned int b);
+    double approachShift(unsigned int a, unsigned int b);       // how far the fibula planes at a and b can be brought together
+
+    const CurveGeometry &mandible;
+    unsigned int leftIndex;
+    unsigned int rightIndex;
+    const CurveGeometry &fibula;
+    unsigned int fibulaIndex;
+    const std::vector<Vec3Df> &fibulaVertices;
+    double constraint;
+    double securityMargin;
+    bool isOptimise;
+
+    const double planeThickness = 0.5;      // how close a vertex has to be to count as on the plane
+};
+
+#endif // PIECECOUNTEVALUATOR_H
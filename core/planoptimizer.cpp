@@ -0,0 +1,178 @@
+#include "planoptimizer.h"
+#include <algorithm>
+#include <random>
+
+PlanOptimizer::PlanOptimizer(const CurveGeometry &curve, double minLength) : curve(curve), minLength(minLength){}
+
+// A candidate is too close if it's less than minLength away from a plane that's already been placed
+bool PlanOptimizer::isTooClose(const CurveGeometry &curve, unsigned int index, const std::vector<unsigned int> &chosen, const std::set<double> &chosenLengths, double minLength){
+    // The straight line is never longer than the arc, so a plane closer than minLength along the curve is always too close
+    const double length = curve.lengthAtIndex(index);
+    std::set<double>::const_iterator next = chosenLengths.lower_bound(length);
+    if(next != chosenLengths.end() && *next - length < minLength) return true;
+    if(next != chosenLengths.begin() && length - *std::prev(next) < minLength) return true;
+
+    // Further along the curve it can still bend back towards the other planes
+    for(unsigned int j=0; j<chosen.size(); j++){
+        if(curve.discreteLength(chosen[j], index) < minLength) return true;
+    }
+    return false;
+}
+
+std::vector<unsigned int> PlanOptimizer::greedyPlan(const CurveGeometry &curve, unsigned int startIndex, unsigned int endIndex, unsigned int nb, double minLength){
+    std::vector<unsigned int> chosen;
+    if(endIndex <= startIndex) return chosen;
+
+    // The possible indexes for the planes, the one where the curve turns the most at the top (the first index wins a tie)
+    typedef std::pair<double, unsigned int> Candidate;
+    auto isLower = [](const Candidate &a, const Candidate &b){ return a.first < b.first || (a.first == b.first && a.second > b.second); };
+    std::vector<Candidate> candidates;
+    candidates.reserve(endIndex - startIndex);
+    for(unsigned int i=startIndex; i<endIndex; i++) candidates.push_back(Candidate(curve.getTurningRate(i), i));
+    std::make_heap(candidates.begin(), candidates.end(), isLower);
+
+    // Only pop as many as needed
+    std::set<double> chosenLengths;     // the chosen planes along the curve
+    while(chosen.size() < nb && candidates.size()!=0){
+        std::pop_heap(candidates.begin(), candidates.end(), isLower);
+        const unsigned int index = candidates.back().second;
+        candidates.pop_back();
+
+        if(isTooClose(curve, index, chosen, chosenLengths, minLength)) continue;
+        chosen.push_back(index);
+        chosenLengths.insert(curve.lengthAtIndex(index));
+    }
+
+    std::sort(chosen.begin(), chosen.end());
+    return chosen;
+}
+
+double PlanOptimizer::segmentCost(unsigned int a, unsigned int b){
+    const Vec3Dd &pa = curve.getPoint(a);
+    Vec3Dd chord = curve.getPoint(b) - pa;
+    double chordLength2 = chord.getSquaredLength();
+    double cost = 0;
+
+    for(unsigned int i=a+1; i<b; i++){
+        Vec3Dd v = curve.getPoint(i) - pa;
+        double d2 = v.getSquaredLength();
+        const double along = Vec3Dd::dotProduct(v, chord);
+        if(chordLength2 > 0) d2 -= along*along / chordLength2;     // Pythagoras : the part of v which isn't along the chord
+        double ds = (curve.lengthAtIndex(i+1) - curve.lengthAtIndex(i-1)) / 2.0;
+        cost += std::max(d2, 0.0) * ds;
+    }
+
+    return cost;
+}
+
+double PlanOptimizer::getCost(const std::vector<unsigned int> &plan){
+    double cost = 0;
+    for(unsigned int i=1; i<plan.size(); i++) cost += segmentCost(plan[i-1], plan[i]);
+    return cost;
+}
+
+bool PlanOptimizer::isValid(const std::vector<unsigned int> &plan){
+    for(unsigned int i=1; i<plan.size(); i++){
+        if(!isSegmentValid(plan[i-1], plan[i])) return false;
+    }
+    return true;
+}
+
+// Each plane is moved by step in both directions while it improves the cost, then the step is halved
+void PlanOptimizer::descend(std::vector<unsigned int> &plan, double &cost){
+    const unsigned int nbSegments = static_cast<unsigned int>(plan.size()-1);
+    unsigned int step = std::max(1u, (plan.back() - plan.front()) / (4*nbSegments));
+
+    while(true){
+        bool isImproved = true;
+        while(isImproved){
+            isImproved = false;
+
+            for(unsigned int i=1; i<nbSegments; i++){
+                const unsigned int previous = plan[i-1];
+                const unsigned int next = plan[i+1];
+                const double currentCost = segmentCost(previous, plan[i]) + segmentCost(plan[i], next);
+
+                for(int direction=-1; direction<=1; direction+=2){
+                    if(direction < 0 && plan[i] < step) continue;
+                    const unsigned int candidate = direction < 0 ? plan[i]-step : plan[i]+step;
+                    if(!isSegmentValid(previous, candidate) || !isSegmentValid(candidate, next)) continue;
+
+                    const double candidateCost = segmentCost(previous, candidate) + segmentCost(candidate, next);
+                    if(candidateCost < currentCost - 1e-12){
+                        cost += candidateCost - currentCost;
+                        plan[i] = candidate;
+                        isImproved = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if(step == 1) break;
+        step /= 2;
+    }
+}
+
+// The plan with the planes at these fractions of the length between the end planes
+bool PlanOptimizer::planAtLengths(unsigned int leftIndex, unsigned int rightIndex, const std::vector<double> &fractions, std::vector<unsigned int> &plan){
+    const double start = curve.lengthAtIndex(leftIndex);
+    const double length = curve.lengthAtIndex(rightIndex) - start;
+
+    plan.clear();
+    plan.push_back(leftIndex);
+    for(unsigned int i=0; i<fractions.size(); i++) plan.push_back(curve.indexAtLength(start + fractions[i]*length));
+    plan.push_back(rightIndex);
+
+    return isValid(plan);
+}
+
+std::vector<unsigned int> PlanOptimizer::optimise(unsigned int leftIndex, unsigned int rightIndex, const std::vector<unsigned int> &initialPlan, ThreadPool &pool){
+    const unsigned int nbGhosts = static_cast<unsigned int>(initialPlan.size());
+    if(nbGhosts == 0) return initialPlan;
+
+    // The starting plans : the one we were given, evenly spaced planes, and random ones
+    std::vector<std::vector<unsigned int>> plans;
+    std::vector<unsigned int> plan;
+
+    plan.push_back(leftIndex);
+    plan.insert(plan.end(), initialPlan.begin(), initialPlan.end());
+    plan.push_back(rightIndex);
+    initialCost = getCost(plan);
+    if(isValid(plan)) plans.push_back(plan);
+
+    const double spacing = 1.0 / static_cast<double>(nbGhosts+1);
+    std::vector<double> even(nbGhosts), fractions(nbGhosts);
+    for(unsigned int i=0; i<nbGhosts; i++) even[i] = static_cast<double>(i+1) * spacing;
+    if(planAtLengths(leftIndex, rightIndex, even, plan)) plans.push_back(plan);
+
+    // Move each plane of the even plan by up to half a piece
+    std::mt19937 generator(nbGhosts);       // the same plan every time for the same curve
+    std::uniform_real_distribution<double> randomShift(-0.5*spacing, 0.5*spacing);
+    const unsigned int nbRandom = nbRandomStarts;
+    for(unsigned int i=0, nbTries=0; i<nbRandom && nbTries<nbRandom*10; nbTries++){
+        for(unsigned int j=0; j<nbGhosts; j++) fractions[j] = even[j] + randomShift(generator);
+        if(planAtLengths(leftIndex, rightIndex, fractions, plan)){
+            plans.push_back(plan);
+            i++;
+        }
+    }
+
+    nbStarts = static_cast<unsigned int>(plans.size());
+    if(nbStarts == 0){
+        lastCost = initialCost;
+        return initialPlan;
+    }
+
+    // The starts don't share anything but the curve, which is only read
+    std::vector<double> costs(plans.size());
+    pool.parallelFor(0, nbStarts, [this, &plans, &costs](unsigned int s){
+        costs[s] = getCost(plans[s]);
+        descend(plans[s], costs[s]);
+    });
+
+    unsigned int best = static_cast<unsigned int>(std::min_element(costs.begin(), costs.end()) - costs.begin());
+    lastCost = costs[best];
+
+    return std::vector<unsigned int>(plans[best].begin()+1, plans[best].end()-1);
+}
@@ -0,0 +1,46 @@
+#ifndef PLANOPTIMIZER_H
+#define PLANOPTIMIZER_H
+
+#include "curvegeometry.h"
+#include "threadpool.h"
+#include <set>
+
+/*
+ * Searches for the ghost plane positions whose polyline follows the curve the most closely.
+ * The cost of a plan is the squared distance from the curve to each chord, summed along the curve.
+ * Every segment has to be at least minLength long (straight line) so the fibula pieces can be cut.
+*/
+class PlanOptimizer
+{
+public:
+    static const unsigned int nbRandomStarts = 8;       // besides the given and the even plans, the same whatever the number of threads so the plan is too
+
+    PlanOptimizer(const CurveGeometry &curve, double minLength);
+
+    // Up to nb planes between startIndex and endIndex where the curve turns the most, each at least minLength from the others
+    static std::vector<unsigned int> greedyPlan(const CurveGeometry &curve, unsigned int startIndex, unsigned int endIndex, unsigned int nb, double minLength);
+
+    // Returns the ghost plane indicies (same number as initialPlan) between the end planes
+    std::vector<unsigned int> optimise(unsigned int leftIndex, unsigned int rightIndex, const std::vector<unsigned int> &initialPlan, ThreadPool &pool);
+
+    double getCost(const std::vector<unsigned int> &plan);      // plan includes the end planes
+    bool isValid(const std::vector<unsigned int> &plan);
+    double getLastCost(){ return lastCost; }
+    double getInitialCost(){ return initialCost; }
+    unsigned int getNbStarts(){ return nbStarts; }
+
+private:
+    static bool isTooClose(const CurveGeometry &curve, unsigned int index, const std::vector<unsigned int> &chosen, const std::set<double> &chosenLengths, double minLength);
+    double segmentCost(unsigned int a, unsigned int b);     // the deviation of the curve between a and b from the chord [a,b]
+    void descend(std::vector<unsigned int> &plan, double &cost);      // coordinate descent, one plane at a time
+    bool isSegmentValid(unsigned int a, unsigned int b){ return b > a && curve.discreteLength(a, b) >= minLength; }
+    bool planAtLengths(unsigned int leftIndex, unsigned int rightIndex, const std::vector<double> &fractions, std::vector<unsigned int> &plan);
+
+    const CurveGeometry &curve;
+    double minLength;
+    double lastCost = 0;
+    double initialCost = 0;
+    unsigned int nbStarts = 0;
+};
+
+#endif // PLANOPTIMIZER_H
@@ -0,0 +1,181 @@
+#include "slabindex.h"
+#include "varint.h"
+#include <algorithm>
+#include <cmath>
+
+static const unsigned int boundsBlockSize = 4096;      // triangles per task
+static const unsigned int slabBlockSize = 4;       // slabs per task
+static const double slabTolerance = 1e-3;       // covers the float centres and reaches (mm)
+
+void SlabIndex::build(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, const CurveGeometry &curve, double halfWidth, double radius, size_t maxBytes, ThreadPool &pool){
+    this->halfWidth = halfWidth;
+    this->radius = radius;
+    this->maxBytes = maxBytes;
+    stride = 1;
+
+    computeBounds(vertices, triangles, pool);
+    fill(curve, pool);
+    while(getBytes() > maxBytes && stride < nbU){
+        stride *= 2;
+        fill(curve, pool);
+    }
+
+    centres = std::vector<Vec3Df>();
+    reaches = std::vector<float>();
+}
+
+void SlabIndex::update(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, const CurveGeometry &curve, unsigned int start, unsigned int end, ThreadPool &pool){
+    if(isEmpty()) return;
+    if(curve.getNbU() != nbU || triangles.size() != nbTriangles || halfWidth + 0.5 * getMaxGap(curve) > slabHalfWidth){
+        build(vertices, triangles, curve, halfWidth, radius, maxBytes, pool);
+        return;
+    }
+
+    const unsigned int first = (start + stride - 1) / stride;
+    const unsigned int last = std::min(static_cast<unsigned int>(lists.size()), (end + stride - 1) / stride);
+    if(first >= last) return;
+
+    computeBounds(vertices, triangles, pool);
+    for(unsigned int k=first; k<last; k++){
+        points[k] = curve.getPoint(k * stride);
+        tangents[k] = curve.tangent(k * stride);
+    }
+    fillSlabs(first, last, pool);
+    centres = std::vector<Vec3Df>();
+    reaches = std::vector<float>();
+
+    if(getBytes() > maxBytes) build(vertices, triangles, curve, halfWidth, radius, maxBytes, pool);
+}
+
+void SlabIndex::clear(){
+    points.clear();
+    tangents.clear();
+    lists.clear();
+    nbCandidates.clear();
+    nbU = 0;
+    nbTriangles = 0;
+}
+
+/*
+ * isIntersection takes the lines of the edges up to one edge length past their ends, so the points it accepts
+ * are within the distance from the centre to the furthest vertex plus the longest edge.
+*/
+void SlabIndex::computeBounds(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, ThreadPool &pool){
+    nbTriangles = static_cast<unsigned int>(triangles.size());
+    centres.resize(nbTriangles);
+    reaches.resize(nbTriangles);
+
+    const unsigned int nbBlocks = (nbTriangles + boundsBlockSize - 1) / boundsBlockSize;
+    pool.parallelFor(0, nbBlocks, [&](unsigned int b){
+        const unsigned int end = std::min(nbTriangles, (b+1) * boundsBlockSize);
+        for(unsigned int t=b*boundsBlockSize; t<end; t++){
+            const Vec3Df &a = vertices[triangles[t].getVertex(0)];
+            const Vec3Df &v1 = vertices[triangles[t].getVertex(1)];
+            const Vec3Df &v2 = vertices[triangles[t].getVertex(2)];
+            centres[t] = (a + v1 + v2) / 3.f;
+
+            float furthest = 0, longest = 0;
+            for(unsigned int j=0; j<3; j++){
+                const Vec3Df &v = vertices[triangles[t].getVertex(j)];
+                furthest = std::max(furthest, (v - centres[t]).getLength());
+                longest = std::max(longest, (vertices[triangles[t].getVertex((j+1)%3)] - v).getLength());
+            }
+            reaches[t] = furthest + longest;
+        }
+    });
+}
+
+void SlabIndex::fill(const CurveGeometry &curve, ThreadPool &pool){
+    nbU = curve.getNbU();
+    const unsigned int nbSlabs = (nbU + stride - 1) / stride;
+    points.resize(nbSlabs);
+    tangents.resize(nbSlabs);
+    for(unsigned int k=0; k<nbSlabs; k++){
+        points[k] = curve.getPoint(k * stride);
+        tangents[k] = curve.tangent(k * stride);
+    }
+    slabHalfWidth = halfWidth + 0.5 * getMaxGap(curve);
+
+    lists.assign(nbSlabs, std::vector<uint8_t>());
+    nbCandidates.assign(nbSlabs, 0);
+    fillSlabs(0, nbSlabs, pool);
+}
+
+void SlabIndex::fillSlabs(unsigned int first, unsigned int last, ThreadPool &pool){
+    const unsigned int nbBlocks = (last - first + slabBlockSize - 1) / slabBlockSize;
+    pool.parallelFor(0, nbBlocks, [&](unsigned int b){
+        const unsigned int end = std::min(last, first + (b+1) * slabBlockSize);
+        for(unsigned int k=first + b*slabBlockSize; k<end; k++){
+            const Vec3Df p(static_cast<float>(points[k][0]), static_cast<float>(points[k][1]), static_cast<float>(points[k][2]));
+            const Vec3Df n(static_cast<float>(tangents[k][0]), static_cast<float>(tangents[k][1]), static_cast<float>(tangents[k][2]));
+            const float width = static_cast<float>(slabHalfWidth + slabTolerance);
+            const float reach = static_cast<float>(radius + slabTolerance);
+
+            std::vector<uint8_t> bytes;
+            unsigned int previous = 0, count = 0;
+            for(unsigned int t=0; t<nbTriangles; t++){
+                const Vec3Df v = centres[t] - p;
+                if(std::abs(Vec3Df::dotProduct(v, n)) > width + reaches[t]) continue;
+                if(v.getSquaredLength() > (reach + reaches[t]) * (reach + reaches[t])) continue;
+                Varint::append(bytes, t - previous);
+                previous = t;
+                count++;
+            }
+            bytes.shrink_to_fit();
+            lists[k].swap(bytes);
+            nbCandidates[k] = count;
+        }
+    });
+}
+
+double SlabIndex::getMaxGap(const CurveGeometry &curve) const{
+    double gap = 0;
+    for(unsigned int i=stride; i<curve.getNbU(); i+=stride) gap = std::max(gap, (curve.getPoint(i) - curve.getPoint(i - stride)).getLength());
+    if(curve.getNbU() != 0 && (curve.getNbU()-1) % stride != 0){
+        const unsigned int last = curve.getNbU() - 1;
+        gap = std::max(gap, 2.0 * (curve.getPoint(last) - curve.getPoint(last - last % stride)).getLength());      // the last samples only have a slab on one side
+    }
+    return gap;
+}
+
+/*
+ * The square reaches size along the x and y axes of its (orthonormal) frame, so all of it is within
+ * size * (|x.t| + |y.t|) of its centre along t and size * sqrt(2) of it. Of the slabs which hold it, the one with the fewest triangles.
+*/
+bool SlabIndex::getCandidates(const CutPlane &plane, std::vector<unsigned int> &candidates) const{
+    candidates.clear();
+    const AffineFrame &frame = plane.getFrame();
+    const double size = plane.getSize();
+
+    int best = -1;
+    for(unsigned int k=0; k<lists.size(); k++){
+        const Vec3Dd v = plane.getPosition() - points[k];
+        const double across = std::abs(Vec3Dd::dotProduct(v, tangents[k])) + size * (std::abs(Vec3Dd::dotProduct(frame.getAxis(0), tangents[k])) + std::abs(Vec3Dd::dotProduct(frame.getAxis(1), tangents[k])));
+        if(across > slabHalfWidth) continue;
+        if(v.getLength() + size * std::sqrt(2.0) > radius) continue;
+        if(best < 0 || nbCandidates[k] < nbCandidates[static_cast<unsigned int>(best)]) best = static_cast<int>(k);
+    }
+    if(best < 0) return false;
+
+    const std::vector<uint8_t> &bytes = lists[static_cast<unsigned int>(best)];
+    candidates.reserve(nbCandidates[static_cast<unsigned int>(best)]);
+    uint32_t t = 0;
+    for(size_t position=0; position<bytes.size();){
+        t += Varint::read(bytes, position);
+        candidates.push_back(t);
+    }
+    return true;
+}
+
+size_t SlabIndex::getBytes() const{
+    size_t bytes = 0;
+    for(unsigned int k=0; k<lists.size(); k++) bytes += lists[k].size();
+    return bytes;
+}
+
+void SlabIndex::reportMemory(MemoryReport &report) const{
+    report.add("slabPoints", points);
+    report.add("slabTangents", tangents);
+    report.add("slabLists", lists);
+    report.add("slabCounts", nbCandidates);
+}
@@ -0,0 +1,58 @@
+#ifndef SLABINDEX_H
+#define SLABINDEX_H
+
+#include "Vec3D.h"
+#include "Triangle.h"
+#include "curvegeometry.h"
+#include "cutplane.h"
+#include "memoryreport.h"
+#include "threadpool.h"
+#include <cstdint>
+#include <vector>
+
+/*
+ * For each sample of a curve, the triangles which reach into a slab around the plane through the sample normal to the tangent
+ * (where the viewers put the cutting planes), so that planeIntersection only tests those instead of the whole mesh.
+ * Each list is sorted and stored as varint deltas. When the lists need more than maxBytes only every other sample is kept
+ * (then every fourth...), with the slabs made thicker to cover the samples in between.
+ * A plane which doesn't fit in any slab gets no candidates, the caller then tests every triangle.
+*/
+class SlabIndex
+{
+public:
+    // The slabs reach halfWidth either side of the samples' planes and radius around the samples
+    void build(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, const CurveGeometry &curve, double halfWidth, double radius, size_t maxBytes, ThreadPool &pool);
+    void update(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, const CurveGeometry &curve, unsigned int start, unsigned int end, ThreadPool &pool);      // the samples [start, end) have moved
+    void clear();
+
+    bool isEmpty() const { return lists.size()==0; }
+    bool getCandidates(const CutPlane &plane, std::vector<unsigned int> &candidates) const;     // false if no slab holds the whole plane
+    unsigned int getStride() const { return stride; }       // the samples kept (every stride-th one)
+    size_t getBytes() const;
+    void reportMemory(MemoryReport &report) const;
+
+private:
+    void computeBounds(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, ThreadPool &pool);
+    void fill(const CurveGeometry &curve, ThreadPool &pool);       // every slab, for the current stride
+    void fillSlabs(unsigned int first, unsigned int last, ThreadPool &pool);
+    double getMaxGap(const CurveGeometry &curve) const;     // the furthest apart two kept samples are
+
+    std::vector<Vec3Dd> points;     // the kept samples
+    std::vector<Vec3Dd> tangents;
+    std::vector<std::vector<uint8_t>> lists;
+    std::vector<unsigned int> nbCandidates;     // the length of each list
+
+    // Only while building : a sphere around each triangle, which also holds the points of its edge lines isIntersection accepts
+    std::vector<Vec3Df> centres;
+    std::vector<float> reaches;
+
+    double halfWidth = 0;
+    double slabHalfWidth = 0;       // halfWidth and half the gap between the kept samples
+    double radius = 0;
+    size_t maxBytes = 0;
+    unsigned int stride = 1;
+    unsigned int nbU = 0;
+    unsigned int nbTriangles = 0;
+};
+
+#endif // SLABINDEX_H
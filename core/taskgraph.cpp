@@ -0,0 +1,143 @@
+#include "taskgraph.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(const Clock::time_point &t0){
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+unsigned int TaskGraph::addTask(const std::string &name, std::function<void ()> f, Affinity affinity){
+    Node n;
+    n.name = name;
+    n.f = f;
+    n.affinity = affinity;
+    n.nbDependencies = 0;
+    n.start = 0;
+    n.duration = 0;
+    nodes.push_back(n);
+    return static_cast<unsigned int>(nodes.size()-1);
+}
+
+void TaskGraph::addDependency(unsigned int before, unsigned int after){
+    nodes[before].successors.push_back(after);
+    nodes[after].nbDependencies++;
+}
+
+void TaskGraph::run(ThreadPool &pool){
+    const Clock::time_point t0 = Clock::now();
+
+    std::mutex mutex;
+    std::condition_variable stageDone;
+    std::vector<unsigned int> remaining(nodes.size());     // the number of unfinished dependencies of each stage
+    std::vector<unsigned int> mainReady;       // MAIN stages waiting for the calling thread
+    unsigned int nbFinished = 0;
+
+    std::function<void(unsigned int)> schedule;
+
+    auto execute = [&](unsigned int i){
+        nodes[i].start = msSince(t0);
+        if(nodes[i].f) nodes[i].f();
+        nodes[i].duration = msSince(t0) - nodes[i].start;
+
+        std::vector<unsigned int> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(unsigned int j=0; j<nodes[i].successors.size(); j++){
+                const unsigned int &s = nodes[i].successors[j];
+                if(--remaining[s] == 0) ready.push_back(s);
+            }
+        }
+
+        for(unsigned int j=0; j<ready.size(); j++) schedule(ready[j]);
+
+        // Last thing we touch : once every stage is counted run() can return and the locals disappear
+        std::lock_guard<std::mutex> lock(mutex);
+        nbFinished++;
+        stageDone.notify_all();
+    };
+
+    schedule = [&](unsigned int i){
+        if(nodes[i].affinity == Affinity::MAIN){
+            std::lock_guard<std::mutex> lock(mutex);
+            mainReady.push_back(i);
+        }
+        else pool.submit([&execute, i](){ execute(i); });
+    };
+
+    for(unsigned int i=0; i<nodes.size(); i++) remaining[i] = nodes[i].nbDependencies;
+    for(unsigned int i=0; i<nodes.size(); i++){
+        if(remaining[i] == 0) schedule(i);
+    }
+
+    // Run the MAIN stages here and help the pool with the rest while waiting
+    while(true){
+        unsigned int next = 0;
+        bool isMainReady = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(nbFinished == nodes.size()) break;
+            if(mainReady.size()!=0){
+                next = mainReady.back();
+                mainReady.pop_back();
+                isMainReady = true;
+            }
+        }
+
+        if(isMainReady) execute(next);
+        else if(!pool.runPendingTask()){
+            std::unique_lock<std::mutex> lock(mutex);
+            stageDone.wait_for(lock, std::chrono::milliseconds(1), [&](){ return nbFinished == nodes.size() || mainReady.size()!=0; });
+        }
+    }
+
+    totalDuration = msSince(t0);
+    if(listener) listener(*this);
+}
+
+double TaskGraph::getCriticalPath() const{
+    // Stages are added after the stages they depend on, so one pass in order is enough
+    std::vector<double> finish(nodes.size(), 0);
+    std::vector<double> earliest(nodes.size(), 0);
+    double longest = 0;
+
+    for(unsigned int i=0; i<nodes.size(); i++){
+        finish[i] = earliest[i] + nodes[i].duration;
+        longest = std::max(longest, finish[i]);
+        for(unsigned int j=0; j<nodes[i].successors.size(); j++){
+            const unsigned int &s = nodes[i].successors[j];
+            earliest[s] = std::max(earliest[s], finish[i]);
+        }
+    }
+
+    return longest;
+}
+
+std::string TaskGraph::toDot() const{
+    std::ostringstream dot;
+    dot << "digraph pipeline {\n";
+
+    for(unsigned int i=0; i<nodes.size(); i++){
+        dot << "  n" << i << " [label=\"" << nodes[i].name << "\\n" << nodes[i].duration << " ms\"";
+        if(nodes[i].affinity == Affinity::MAIN) dot << " shape=box";
+        dot << "];\n";
+    }
+
+    for(unsigned int i=0; i<nodes.size(); i++){
+        for(unsigned int j=0; j<nodes[i].successors.size(); j++) dot << "  n" << i << " -> n" << nodes[i].successors[j] << ";\n";
+    }
+
+    dot << "}\n";
+    return dot.str();
+}
+
+void TaskGraph::printTimings(std::ostream &out) const{
+    for(unsigned int i=0; i<nodes.size(); i++){
+        out << nodes[i].name << " : start " << nodes[i].start << " ms, " << nodes[i].duration << " ms" << std::endl;
+    }
+    out << "total : " << totalDuration << " ms (critical path " << getCriticalPath() << " ms)" << std::endl;
+}
@@ -0,0 +1,51 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "threadpool.h"
+
+// A DAG of named stages. Stages without dependencies between them run concurrently on the pool, and each stage is timed
+class TaskGraph
+{
+public:
+    enum Affinity {ANY, MAIN};      // MAIN stages touch Qt or GL state and always run on the thread calling run()
+    typedef std::function<void(const TaskGraph&)> RunListener;
+
+    unsigned int addTask(const std::string &name, std::function<void()> f, Affinity affinity = Affinity::ANY);
+    void addDependency(unsigned int before, unsigned int after);        // after can't start until before has finished
+    void clear(){ nodes.clear(); }
+
+    void run(ThreadPool &pool);
+    void setRunListener(RunListener listener){ this->listener = listener; }       // called at the end of every run, clear() keeps it
+
+    unsigned int getNbTasks() const { return static_cast<unsigned int>(nodes.size()); }
+    const std::string& getName(unsigned int task) const { return nodes[task].name; }
+    double getStart(unsigned int task) const { return nodes[task].start; }         // ms since the start of the last run
+    double getDuration(unsigned int task) const { return nodes[task].duration; }   // ms
+    double getTotalDuration() const { return totalDuration; }
+    double getCriticalPath() const;     // the longest chain of dependent stages in the last run (ms)
+
+    std::string toDot() const;      // graphviz description of the stages, their dependencies and their last timings
+    void printTimings(std::ostream &out) const;
+
+private:
+    struct Node{
+        std::string name;
+        std::function<void()> f;
+        Affinity affinity;
+        std::vector<unsigned int> successors;
+        unsigned int nbDependencies;
+        double start;
+        double duration;
+    };
+
+    std::vector<Node> nodes;
+    double totalDuration = 0;
+    RunListener listener;
+};
+
+#endif // TASKGRAPH_H
@@ -0,0 +1,148 @@
+#include "threadpool.h"
+#include "trace.h"
+#include <algorithm>
+
+// The pool and queue the current thread works for (null for threads outside of any pool)
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local unsigned int currentWorker = 0;
+
+ThreadPool::ThreadPool(unsigned int nbThreads){
+    if(nbThreads == 0) nbThreads = std::thread::hardware_concurrency();
+    if(nbThreads == 0) nbThreads = 1;
+
+    nbQueued = 0;
+    nextQueue = 0;
+    isStopping = false;
+
+    for(unsigned int i=0; i<nbThreads; i++) queues.push_back(new Queue());
+    for(unsigned int i=0; i<nbThreads; i++) workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isStopping = true;
+    }
+    wakeUp.notify_all();
+
+    for(unsigned int i=0; i<workers.size(); i++) workers[i].join();
+    for(unsigned int i=0; i<queues.size(); i++) delete queues[i];
+}
+
+ThreadPool& ThreadPool::global(){
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(Task task){
+    unsigned int index;
+    if(currentPool == this) index = currentWorker;      // keep the work local, the others will steal it if they're idle
+    else index = nextQueue++ % static_cast<unsigned int>(queues.size());
+
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        nbQueued++;
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::popTask(unsigned int index, Task &task){
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    if(queues[index]->tasks.empty()) return false;
+
+    task = std::move(queues[index]->tasks.back());
+    queues[index]->tasks.pop_back();
+    nbQueued--;
+    return true;
+}
+
+bool ThreadPool::stealTask(unsigned int thief, Task &task){
+    const unsigned int nbQueues = static_cast<unsigned int>(queues.size());
+
+    for(unsigned int i=1; i<=nbQueues; i++){
+        Queue *victim = queues[(thief + i) % nbQueues];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if(victim->tasks.empty()) continue;
+
+        task = std::move(victim->tasks.front());        // take the oldest task (usually the biggest)
+        victim->tasks.pop_front();
+        nbQueued--;
+        return true;
+    }
+
+    return false;
+}
+
+bool ThreadPool::runPendingTask(){
+    Task task;
+
+    if(currentPool == this){
+        if(!popTask(currentWorker, task) && !stealTask(currentWorker, task)) return false;
+    }
+    else if(!stealTask(0, task)) return false;
+
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(unsigned int index){
+    currentPool = this;
+    currentWorker = index;
+    if(Trace::isEnabled()) Trace::setThreadName("pool " + std::to_string(index));
+
+    while(true){
+        Task task;
+        if(popTask(index, task) || stealTask(index, task)){
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this](){ return isStopping || nbQueued > 0; });
+        if(isStopping && nbQueued == 0) return;
+    }
+}
+
+// Split [start, end) into blocks, the calling thread takes blocks as well so nested calls can't starve the pool
+void ThreadPool::parallelFor(unsigned int start, unsigned int end, const std::function<void (unsigned int)> &f){
+    if(start >= end) return;
+
+    const unsigned int nbIndicies = end - start;
+    const unsigned int nbBlocks = std::min(nbIndicies, getNbThreads() * 4);
+    const unsigned int blockSize = (nbIndicies + nbBlocks - 1) / nbBlocks;
+
+    std::atomic<unsigned int> nextBlock(0);
+    std::atomic<unsigned int> blocksDone(0);
+
+    auto work = [&](){
+        unsigned int b;
+        while((b = nextBlock++) < nbBlocks){
+            unsigned int blockStart = start + b * blockSize;
+            unsigned int blockEnd = std::min(end, blockStart + blockSize);
+            for(unsigned int i=blockStart; i<blockEnd; i++) f(i);
+            blocksDone++;
+        }
+    };
+
+    // One helper per worker at most, the ones that start late find nothing left and return straight away
+    const unsigned int nbHelpers = std::min(getNbThreads(), nbBlocks - 1);
+    std::atomic<unsigned int> helpersDone(0);
+    for(unsigned int i=0; i<nbHelpers; i++){
+        submit([&work, &helpersDone](){
+            work();
+            helpersDone++;
+        });
+    }
+
+    work();
+
+    // Wait for the blocks taken by the other threads (and for the helpers to leave before the locals go out of scope)
+    while(blocksDone < nbBlocks || helpersDone < nbHelpers){
+        if(!runPendingTask()) std::this_thread::yield();
+    }
+}
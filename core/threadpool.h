@@ -0,0 +1,48 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool : each worker pops its own tasks from the back of its queue and steals from the front of the others
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    ThreadPool(unsigned int nbThreads = 0);     // 0 : one worker per hardware thread
+    ~ThreadPool();
+
+    static ThreadPool& global();        // shared by the viewers and the meshes
+
+    void submit(Task task);
+    bool runPendingTask();      // run one queued task on the calling thread (used to help instead of blocking)
+    void parallelFor(unsigned int start, unsigned int end, const std::function<void(unsigned int)> &f);     // blocks until f has been called for every index
+    unsigned int getNbThreads() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    struct Queue{
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned int index);
+    bool popTask(unsigned int index, Task &task);
+    bool stealTask(unsigned int thief, Task &task);
+
+    std::vector<std::thread> workers;
+    std::vector<Queue*> queues;     // one per worker
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<unsigned int> nbQueued;
+    std::atomic<unsigned int> nextQueue;
+    bool isStopping;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,113 @@
+#include "trace.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace{
+    const size_t ringSize = 1 << 14;        // events kept per thread
+
+    struct Ring{
+        std::array<Trace::Event, ringSize> events;
+        std::atomic<uint64_t> head{0};      // the number of events ever written, only the owner thread writes it
+        unsigned int threadNb = 0;
+        std::string threadName;
+    };
+
+    // The rings outlive their threads so the events of the finished threads can still be saved
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    Ring& threadRing(){
+        thread_local Ring *ring = nullptr;
+        if(!ring){
+            std::unique_ptr<Ring> r(new Ring);
+            std::lock_guard<std::mutex> lock(registryMutex);
+            r->threadNb = static_cast<unsigned int>(rings.size()) + 1;
+            ring = r.get();
+            rings.push_back(std::move(r));
+        }
+        return *ring;
+    }
+
+    int64_t now(){
+        static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    // Names are literals from our own code but keep the JSON valid anyway
+    std::string escape(const std::string &s){
+        std::string e;
+        for(unsigned int i=0; i<s.size(); i++){
+            if(s[i]=='"' || s[i]=='\\') e += '\\';
+            e += s[i];
+        }
+        return e;
+    }
+}
+
+Trace::Scope::Scope(const char *name) : name(name), start(now()){}
+
+Trace::Scope::~Scope(){
+    Ring &ring = threadRing();
+    const uint64_t h = ring.head.load(std::memory_order_relaxed);
+    Event &e = ring.events[h % ringSize];
+    e.name = name;
+    e.start = start;
+    e.duration = now() - start;
+    ring.head.store(h+1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const std::string &name){
+    Ring &ring = threadRing();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    ring.threadName = name;
+}
+
+bool Trace::save(const std::string &fileName){
+    if(!isEnabled()){
+        std::cout << "Tracing isn't compiled in (build with CONFIG+=tracing)" << std::endl;
+        return false;
+    }
+
+    std::ofstream file(fileName);
+    if(!file.is_open()){
+        std::cout << fileName << " cannot be opened" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool isFirst = true;
+    unsigned int nbEvents = 0;
+    for(unsigned int r=0; r<rings.size(); r++){
+        const Ring &ring = *rings[r];
+        const std::string threadName = ring.threadName.empty() ? "thread " + std::to_string(ring.threadNb) : ring.threadName;
+        file << (isFirst ? "" : ",") << "\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << ring.threadNb
+             << ", \"args\": {\"name\": \"" << escape(threadName) << "\"}}";
+        isFirst = false;
+
+        // Copy first : the owner keeps writing, so whatever it may have overwritten meanwhile is dropped
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        const uint64_t first = head > ringSize ? head - ringSize : 0;
+        std::vector<Event> copy;
+        for(uint64_t i=first; i<head; i++) copy.push_back(ring.events[i % ringSize]);
+        const uint64_t newHead = ring.head.load(std::memory_order_acquire);
+
+        for(uint64_t i=first; i<head; i++){
+            if(i + ringSize <= newHead) continue;       // overwritten, or in the slot of event newHead which may be half written
+            const Event &e = copy[i - first];
+            file << ",\n{\"ph\": \"X\", \"name\": \"" << escape(e.name) << "\", \"pid\": 1, \"tid\": " << ring.threadNb
+                 << ", \"ts\": " << static_cast<double>(e.start) / 1000. << ", \"dur\": " << static_cast<double>(e.duration) / 1000. << "}";
+            nbEvents++;
+        }
+    }
+    file << "\n]}\n";
+
+    std::cout << nbEvents << " trace events saved in " << fileName << std::endl;
+    return true;
+}
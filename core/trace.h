@@ -0,0 +1,53 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Scoped timers for the hot paths, exported as a Chrome / Perfetto trace (chrome://tracing, ui.perfetto.dev).
+ * Only compiled in with MEDMAX_TRACING (qmake CONFIG+=tracing), otherwise MEDMAX_TRACE expands to nothing.
+ *
+ * Each thread writes its events to its own ring buffer, so tracing takes no lock : once a ring is full the oldest
+ * events are overwritten. The names must be string literals (only the pointer is kept).
+*/
+namespace Trace{
+    struct Event{
+        const char *name;
+        int64_t start;      // ns since the first event
+        int64_t duration;       // ns
+    };
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+
+    private:
+        const char *name;
+        int64_t start;
+    };
+
+    constexpr bool isEnabled(){
+#ifdef MEDMAX_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool save(const std::string &fileName);     // the events still in the rings, as trace JSON
+    void setThreadName(const std::string &name);        // shown instead of the thread number
+}
+
+#define MEDMAX_TRACE_CONCAT2(a, b) a##b
+#define MEDMAX_TRACE_CONCAT(a, b) MEDMAX_TRACE_CONCAT2(a, b)
+
+#ifdef MEDMAX_TRACING
+#define MEDMAX_TRACE(name) Trace::Scope MEDMAX_TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define MEDMAX_TRACE(name)
+#endif
+
+#endif // TRACE_H
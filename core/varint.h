@@ -0,0 +1,49 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <cstdint>
+#include <vector>
+
+// Integers on as few bytes as they need, 7 bits per byte (the high bit says another byte follows)
+namespace Varint{
+    inline void append(std::vector<uint8_t> &bytes, uint32_t value){
+        while(value >= 0x80){
+            bytes.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    inline uint32_t read(const std::vector<uint8_t> &bytes, size_t &position){
+        uint32_t value = 0;
+        for(unsigned int shift=0; ; shift+=7){
+            const uint8_t byte = bytes[position++];
+            value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if((byte & 0x80) == 0) return value;
+        }
+    }
+
+    // Small negative values on few bytes too (0, -1, 1, -2... become 0, 1, 2, 3...)
+    inline uint32_t zigzag(int32_t value){ return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31); }
+    inline int32_t unzigzag(uint32_t value){ return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1); }
+
+    // The differences between one index and the next, in any order (they are only short when the indicies are close)
+    inline void appendDeltas(std::vector<uint8_t> &bytes, const std::vector<unsigned int> &indicies){
+        uint32_t previous = 0;
+        for(size_t i=0; i<indicies.size(); i++){
+            append(bytes, zigzag(static_cast<int32_t>(indicies[i] - previous)));
+            previous = indicies[i];
+        }
+    }
+
+    inline void readDeltas(const std::vector<uint8_t> &bytes, std::vector<unsigned int> &indicies){
+        indicies.clear();
+        uint32_t previous = 0;
+        for(size_t position=0; position<bytes.size();){
+            previous += static_cast<uint32_t>(unzigzag(read(bytes, position)));
+            indicies.push_back(previous);
+        }
+    }
+}
+
+#endif // VARINT_H
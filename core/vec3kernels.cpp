@@ -0,0 +1,211 @@
+#include "vec3kernels.h"
+#include <algorithm>
+#include <float.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void Vec3Kernels::Scalar::boundingBox(const std::vector<Vec3Df> &points, Vec3Df &bbMin, Vec3Df &bbMax){
+    bbMin = Vec3Df(FLT_MAX, FLT_MAX, FLT_MAX);
+    bbMax = Vec3Df(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for(unsigned int i=0; i<points.size(); i++){
+        for(int k=0; k<3; k++){
+            bbMin[k] = std::min(bbMin[k], points[i][k]);
+            bbMax[k] = std::max(bbMax[k], points[i][k]);
+        }
+    }
+}
+
+void Vec3Kernels::Scalar::accumulateTriangleNormals(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, std::vector<Vec3Df> &normals){
+    for(unsigned int t=0; t<triangles.size(); t++){
+        const Vec3Df &a = vertices[triangles[t].getVertex(0)];
+        Vec3Df n = Vec3Df::crossProduct(vertices[triangles[t].getVertex(1)] - a, vertices[triangles[t].getVertex(2)] - a);
+        n.normalize();
+        for(unsigned int j=0; j<3; j++) normals[triangles[t].getVertex(j)] += n;
+    }
+}
+
+void Vec3Kernels::Scalar::normalize(std::vector<Vec3Df> &vectors){
+    for(unsigned int i=0; i<vectors.size(); i++) vectors[i].normalize();
+}
+
+#ifdef __SSE2__
+
+// x, y and z of 4 vectors
+struct Vec3x4{
+    __m128 x, y, z;
+};
+
+static inline Vec3x4 load(const Vec3Df &a, const Vec3Df &b, const Vec3Df &c, const Vec3Df &d){
+    Vec3x4 r;
+    r.x = _mm_setr_ps(a[0], b[0], c[0], d[0]);
+    r.y = _mm_setr_ps(a[1], b[1], c[1], d[1]);
+    r.z = _mm_setr_ps(a[2], b[2], c[2], d[2]);
+    return r;
+}
+
+static inline Vec3x4 sub(const Vec3x4 &a, const Vec3x4 &b){
+    Vec3x4 r;
+    r.x = _mm_sub_ps(a.x, b.x);
+    r.y = _mm_sub_ps(a.y, b.y);
+    r.z = _mm_sub_ps(a.z, b.z);
+    return r;
+}
+
+static inline Vec3x4 cross(const Vec3x4 &a, const Vec3x4 &b){
+    Vec3x4 r;
+    r.x = _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y));
+    r.y = _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z));
+    r.z = _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x));
+    return r;
+}
+
+static inline __m128 dot(const Vec3x4 &a, const Vec3x4 &b){
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+// As Vec3Df::normalize : multiplied by 1/length, left as it is when the length is 0
+static inline void normalise(Vec3x4 &v){
+    const __m128 length = _mm_sqrt_ps(dot(v, v));
+    const __m128 isZero = _mm_cmpeq_ps(length, _mm_setzero_ps());
+    const __m128 inverse = _mm_andnot_ps(isZero, _mm_div_ps(_mm_set1_ps(1.f), length));
+    const __m128 scale = _mm_or_ps(inverse, _mm_and_ps(isZero, _mm_set1_ps(1.f)));
+    v.x = _mm_mul_ps(v.x, scale);
+    v.y = _mm_mul_ps(v.y, scale);
+    v.z = _mm_mul_ps(v.z, scale);
+}
+
+/*
+ * The array read as floats, 4 points (12 floats) at a time : the 3 registers hold x y z x, y z x y and z x y z,
+ * so each lane of each register always sees the same coordinate.
+*/
+void Vec3Kernels::boundingBox(const std::vector<Vec3Df> &points, Vec3Df &bbMin, Vec3Df &bbMax){
+    const size_t nbBlocks = points.size() / 4;
+    const float *f = nbBlocks!=0 ? &points[0][0] : nullptr;
+
+    __m128 min0 = _mm_set1_ps(FLT_MAX), min1 = min0, min2 = min0;
+    __m128 max0 = _mm_set1_ps(-FLT_MAX), max1 = max0, max2 = max0;
+    for(size_t b=0; b<nbBlocks; b++, f+=12){
+        const __m128 r0 = _mm_loadu_ps(f);
+        const __m128 r1 = _mm_loadu_ps(f + 4);
+        const __m128 r2 = _mm_loadu_ps(f + 8);
+        min0 = _mm_min_ps(min0, r0);
+        min1 = _mm_min_ps(min1, r1);
+        min2 = _mm_min_ps(min2, r2);
+        max0 = _mm_max_ps(max0, r0);
+        max1 = _mm_max_ps(max1, r1);
+        max2 = _mm_max_ps(max2, r2);
+    }
+
+    float mins[12], maxs[12];
+    _mm_storeu_ps(mins, min0);
+    _mm_storeu_ps(mins + 4, min1);
+    _mm_storeu_ps(mins + 8, min2);
+    _mm_storeu_ps(maxs, max0);
+    _mm_storeu_ps(maxs + 4, max1);
+    _mm_storeu_ps(maxs + 8, max2);
+
+    bbMin = Vec3Df(FLT_MAX, FLT_MAX, FLT_MAX);
+    bbMax = Vec3Df(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for(int i=0; i<12; i++){
+        bbMin[i%3] = std::min(bbMin[i%3], mins[i]);
+        bbMax[i%3] = std::max(bbMax[i%3], maxs[i]);
+    }
+    for(size_t i=4*nbBlocks; i<points.size(); i++){
+        for(int k=0; k<3; k++){
+            bbMin[k] = std::min(bbMin[k], points[i][k]);
+            bbMax[k] = std::max(bbMax[k], points[i][k]);
+        }
+    }
+}
+
+static inline Vec3x4 triangleNormals4(const std::vector<Vec3Df> &vertices, const Triangle *t){
+    const Vec3x4 a = load(vertices[t[0].getVertex(0)], vertices[t[1].getVertex(0)], vertices[t[2].getVertex(0)], vertices[t[3].getVertex(0)]);
+    const Vec3x4 v1 = load(vertices[t[0].getVertex(1)], vertices[t[1].getVertex(1)], vertices[t[2].getVertex(1)], vertices[t[3].getVertex(1)]);
+    const Vec3x4 v2 = load(vertices[t[0].getVertex(2)], vertices[t[1].getVertex(2)], vertices[t[2].getVertex(2)], vertices[t[3].getVertex(2)]);
+
+    Vec3x4 n = cross(sub(v1, a), sub(v2, a));
+    normalise(n);
+    return n;
+}
+
+// The normals of 4 triangles at once, then added to their verticies one triangle after the other
+void Vec3Kernels::accumulateTriangleNormals(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, std::vector<Vec3Df> &normals){
+    const size_t nbBlocks = triangles.size() / 4;
+    alignas(16) float x[4], y[4], z[4];
+
+    for(size_t b=0; b<nbBlocks; b++){
+        const Triangle *t = &triangles[4*b];
+        const Vec3x4 n = triangleNormals4(vertices, t);
+        _mm_store_ps(x, n.x);
+        _mm_store_ps(y, n.y);
+        _mm_store_ps(z, n.z);
+
+        for(unsigned int l=0; l<4; l++){
+            const Vec3Df ln(x[l], y[l], z[l]);
+            for(unsigned int j=0; j<3; j++) normals[t[l].getVertex(j)] += ln;
+        }
+    }
+
+    for(size_t i=4*nbBlocks; i<triangles.size(); i++){
+        const Vec3Df &a = vertices[triangles[i].getVertex(0)];
+        Vec3Df n = Vec3Df::crossProduct(vertices[triangles[i].getVertex(1)] - a, vertices[triangles[i].getVertex(2)] - a);
+        n.normalize();
+        for(unsigned int j=0; j<3; j++) normals[triangles[i].getVertex(j)] += n;
+    }
+}
+
+void Vec3Kernels::triangleNormals(const std::vector<Vec3Df> &vertices, const Triangle *triangles, size_t nbTriangles, Vec3Df *normals){
+    const size_t nbBlocks = nbTriangles / 4;
+    alignas(16) float x[4], y[4], z[4];
+
+    for(size_t b=0; b<nbBlocks; b++){
+        const Vec3x4 n = triangleNormals4(vertices, triangles + 4*b);
+        _mm_store_ps(x, n.x);
+        _mm_store_ps(y, n.y);
+        _mm_store_ps(z, n.z);
+        for(unsigned int l=0; l<4; l++) normals[4*b + l] = Vec3Df(x[l], y[l], z[l]);
+    }
+
+    for(size_t i=4*nbBlocks; i<nbTriangles; i++){
+        const Vec3Df &a = vertices[triangles[i].getVertex(0)];
+        normals[i] = Vec3Df::crossProduct(vertices[triangles[i].getVertex(1)] - a, vertices[triangles[i].getVertex(2)] - a);
+        normals[i].normalize();
+    }
+}
+
+void Vec3Kernels::normalize(Vec3Df *vectors, size_t nbVectors){
+    const size_t nbBlocks = nbVectors / 4;
+    alignas(16) float x[4], y[4], z[4];
+
+    for(size_t b=0; b<nbBlocks; b++){
+        Vec3Df *v = vectors + 4*b;
+        Vec3x4 n = load(v[0], v[1], v[2], v[3]);
+        normalise(n);
+        _mm_store_ps(x, n.x);
+        _mm_store_ps(y, n.y);
+        _mm_store_ps(z, n.z);
+        for(unsigned int l=0; l<4; l++) v[l] = Vec3Df(x[l], y[l], z[l]);
+    }
+
+    for(size_t i=4*nbBlocks; i<nbVectors; i++) vectors[i].normalize();
+}
+
+#else
+
+void Vec3Kernels::boundingBox(const std::vector<Vec3Df> &points, Vec3Df &bbMin, Vec3Df &bbMax){ Scalar::boundingBox(points, bbMin, bbMax); }
+void Vec3Kernels::accumulateTriangleNormals(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, std::vector<Vec3Df> &normals){ Scalar::accumulateTriangleNormals(vertices, triangles, normals); }
+void Vec3Kernels::triangleNormals(const std::vector<Vec3Df> &vertices, const Triangle *triangles, size_t nbTriangles, Vec3Df *normals){
+    for(size_t i=0; i<nbTriangles; i++){
+        const Vec3Df &a = vertices[triangles[i].getVertex(0)];
+        normals[i] = Vec3Df::crossProduct(vertices[triangles[i].getVertex(1)] - a, vertices[triangles[i].getVertex(2)] - a);
+        normals[i].normalize();
+    }
+}
+
+void Vec3Kernels::normalize(Vec3Df *vectors, size_t nbVectors){
+    for(size_t i=0; i<nbVectors; i++) vectors[i].normalize();
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef VEC3KERNELS_H
+#define VEC3KERNELS_H
+
+#include "Vec3D.h"
+#include "Triangle.h"
+#include <vector>
+
+/*
+ * The loops over whole vertex arrays, 4 vectors at a time with SSE. The arrays stay Vec3Df (12 bytes, what OpenGL and
+ * CompactMesh read), the kernels load them into x, y and z registers themselves.
+ * The operations are the same, in the same order, as the scalar versions, so the results are identical.
+ * Without SSE (not x86) the scalar versions are used.
+*/
+namespace Vec3Kernels{
+    constexpr bool isVectorised(){
+#ifdef __SSE2__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // bbMin and bbMax are FLT_MAX and -FLT_MAX when there are no points
+    void boundingBox(const std::vector<Vec3Df> &points, Vec3Df &bbMin, Vec3Df &bbMax);
+
+    // Adds the unit normal of each triangle to its 3 verticies, in the order of the triangles
+    void accumulateTriangleNormals(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, std::vector<Vec3Df> &normals);
+
+    // normals[i] = the unit normal of triangles[i], for nbTriangles triangles
+    void triangleNormals(const std::vector<Vec3Df> &vertices, const Triangle *triangles, size_t nbTriangles, Vec3Df *normals);
+
+    // Same as Vec3Df::normalize on each vector (0 stays 0)
+    void normalize(Vec3Df *vectors, size_t nbVectors);
+    inline void normalize(std::vector<Vec3Df> &vectors){ if(vectors.size()!=0) normalize(vectors.data(), vectors.size()); }
+
+    // The loops as they were, to compare with in the benchmark
+    namespace Scalar{
+        void boundingBox(const std::vector<Vec3Df> &points, Vec3Df &bbMin, Vec3Df &bbMax);
+        void accumulateTriangleNormals(const std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, std::vector<Vec3Df> &normals);
+        void normalize(std::vector<Vec3Df> &vectors);
+    }
+}
+
+#endif // VEC3KERNELS_H
@@ -0,0 +1,15 @@
+# Builds the planning engine first, then the viewers, the benchmarks, the mesh generator and the batch planner which link against it.
+
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    core \
+    multiView \
+    benchmark \
+    meshgen \
+    batch
+
+multiView.depends = core
+benchmark.depends = core
+meshgen.depends = core
+batch.depends = core
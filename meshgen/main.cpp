@@ -0,0 +1,159 @@
+#include "meshsynth.h"
+#include "meshreader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Target{
+    std::string label;      // as given, used in the file names
+    unsigned long long nbTriangles;
+};
+
+static void printUsage(){
+    std::cout << "meshgen [options] <mesh.off|mesh.ply>" << std::endl
+              << "Makes bigger meshes out of a real one for the scaling benchmarks." << std::endl
+              << "  --triangles <list>         the sizes to reach (100k,1M,10M,50M)" << std::endl
+              << "  --method loop|midpoint|none  how to subdivide (loop)" << std::endl
+              << "  --tile                     fill up to the size with copies of the subdivided mesh" << std::endl
+              << "  --jitter <amount>          move the verticies by up to amount times the average edge length (0)" << std::endl
+              << "  --seed <n>                 for the jitter (1)" << std::endl
+              << "  --format ply|off|both      binary PLY, OFF or both (ply)" << std::endl
+              << "  --out <dir>                an existing directory (.)" << std::endl
+              << "  --name <name>              the start of the file names (the mesh's name)" << std::endl;
+}
+
+// 100k, 2.5M, 50000...
+static bool parseTargets(const std::string &list, std::vector<Target> &targets){
+    size_t start = 0;
+    while(start < list.size()){
+        size_t end = list.find(',', start);
+        if(end == std::string::npos) end = list.size();
+        const std::string item = list.substr(start, end-start);
+
+        char *suffix = nullptr;
+        double n = strtod(item.c_str(), &suffix);
+        if(*suffix=='k' || *suffix=='K') n *= 1e3;
+        else if(*suffix=='m' || *suffix=='M') n *= 1e6;
+        else if(*suffix != '\0') return false;
+        if(n < 1) return false;
+
+        Target t;
+        t.label = item;
+        t.nbTriangles = static_cast<unsigned long long>(n);
+        targets.push_back(t);
+        start = end+1;
+    }
+    return targets.size() != 0;
+}
+
+// The name of the file without the directories or the extension
+static std::string stem(const std::string &fileName){
+    size_t start = fileName.find_last_of("/\\");
+    start = start==std::string::npos ? 0 : start+1;
+    size_t end = fileName.find_last_of('.');
+    if(end==std::string::npos || end < start) end = fileName.size();
+    return fileName.substr(start, end-start);
+}
+
+static double msSince(const Clock::time_point &t0){
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+int main(int argc, char *argv[])
+{
+    std::string input, outDir = ".", name, format = "ply";
+    std::string targetList = "100k,1M,10M,50M";
+    std::string methodName = "loop";
+    bool isTile = false;
+    float jitterAmount = 0;
+    unsigned int seed = 1;
+
+    for(int i=1; i<argc; i++){
+        const bool hasValue = i+1 < argc;
+        if(!strcmp(argv[i], "--triangles") && hasValue) targetList = argv[++i];
+        else if(!strcmp(argv[i], "--method") && hasValue) methodName = argv[++i];
+        else if(!strcmp(argv[i], "--tile")) isTile = true;
+        else if(!strcmp(argv[i], "--jitter") && hasValue) jitterAmount = static_cast<float>(atof(argv[++i]));
+        else if(!strcmp(argv[i], "--seed") && hasValue) seed = static_cast<unsigned int>(atoi(argv[++i]));
+        else if(!strcmp(argv[i], "--format") && hasValue) format = argv[++i];
+        else if(!strcmp(argv[i], "--out") && hasValue) outDir = argv[++i];
+        else if(!strcmp(argv[i], "--name") && hasValue) name = argv[++i];
+        else if(argv[i][0] != '-' && input.empty()) input = argv[i];
+        else{
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::vector<Target> targets;
+    const bool isMethodKnown = methodName=="loop" || methodName=="midpoint" || methodName=="none";
+    const bool isFormatKnown = format=="ply" || format=="off" || format=="both";
+    if(input.empty() || !isMethodKnown || !isFormatKnown || !parseTargets(targetList, targets)){
+        printUsage();
+        return 2;
+    }
+    if(methodName=="none" && !isTile){
+        std::cout << "Without subdividing, --tile is the only way to grow the mesh" << std::endl;
+        return 2;
+    }
+    if(name.empty()) name = stem(input);
+    std::sort(targets.begin(), targets.end(), [](const Target &a, const Target &b){ return a.nbTriangles < b.nbTriangles; });
+
+    std::vector<Vec3Df> vertices;
+    std::vector<Triangle> triangles;
+    if(!FileIO::openMesh(input, vertices, triangles) || triangles.size()==0) return 1;
+    std::cout << input << " : " << vertices.size() << " verticies, " << triangles.size() << " triangles" << std::endl;
+
+    // The targets are in order, so each level of subdivision is only done once
+    unsigned int level = 0;
+    for(unsigned int i=0; i<targets.size(); i++){
+        const double target = static_cast<double>(targets[i].nbTriangles);
+
+        if(methodName != "none"){
+            const MeshSynth::Method method = methodName=="loop" ? MeshSynth::LOOP : MeshSynth::MIDPOINT;
+            while(true){
+                const double size = static_cast<double>(triangles.size());
+                // When tiling, stay below the target and let the copies make up the rest, otherwise take the closest size
+                const bool isSubdivide = isTile ? size*4 <= target : std::abs(std::log(size*4/target)) < std::abs(std::log(size/target));
+                if(!isSubdivide) break;
+
+                Clock::time_point t0 = Clock::now();
+                MeshSynth::subdivide(vertices, triangles, method);
+                level++;
+                std::cout << "  level " << level << " : " << triangles.size() << " triangles (" << msSince(t0) << " ms)" << std::endl;
+            }
+        }
+
+        const unsigned int nbCopies = isTile ? static_cast<unsigned int>(std::max(1.0, std::round(target / triangles.size()))) : 1;
+
+        // Only copy the mesh when it changes, the subdivided one is still needed for the next target
+        std::vector<Vec3Df> outVertices;
+        std::vector<Triangle> outTriangles;
+        const bool isCopy = nbCopies > 1 || jitterAmount > 0;
+        if(isCopy){
+            outVertices = vertices;
+            outTriangles = triangles;
+            MeshSynth::tile(outVertices, outTriangles, nbCopies);
+            MeshSynth::jitter(outVertices, outTriangles, jitterAmount, seed);
+        }
+        const std::vector<Vec3Df> &v = isCopy ? outVertices : vertices;
+        const std::vector<Triangle> &t = isCopy ? outTriangles : triangles;
+
+        const std::string base = outDir + "/" + name + "_" + targets[i].label;
+        Clock::time_point t0 = Clock::now();
+        bool isSaved = true;
+        if(format != "off") isSaved &= FileIO::savePLY(base + ".ply", v, t);
+        if(format != "ply") isSaved &= FileIO::saveOFF(base + ".off", v, t);
+        if(!isSaved) return 1;
+
+        std::cout << base << " : " << v.size() << " verticies, " << t.size() << " triangles";
+        if(nbCopies > 1) std::cout << " (" << nbCopies << " copies)";
+        std::cout << ", written in " << msSince(t0) << " ms" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+# Makes bigger meshes from the bundled ones (subdivision, tiling, jitter) for the scaling benchmarks.
+
+TEMPLATE = app
+TARGET   = meshgen
+
+CONFIG += console warn_on thread c++14
+CONFIG -= qt app_bundle
+
+HEADERS  = meshsynth.h
+SOURCES  = \
+    main.cpp \
+    meshsynth.cpp
+
+include( ../core/core.pri )
@@ -0,0 +1,132 @@
+#include "meshsynth.h"
+#include <algorithm>
+#include <cstdint>
+#include <float.h>
+#include <random>
+#include <utility>
+
+namespace MeshSynth{
+
+// An edge is found by sorting the half edges by their verticies, which uses a lot less memory than a map on big meshes
+void subdivide(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles, Method method){
+    const unsigned int nbVertices = static_cast<unsigned int>(vertices.size());
+    const unsigned int nbTriangles = static_cast<unsigned int>(triangles.size());
+
+    std::vector<std::pair<uint64_t, unsigned int>> halfEdges;       // (smallest vertex, largest vertex) and triangle*3 + the edge's index in the triangle
+    halfEdges.reserve(static_cast<size_t>(nbTriangles)*3);
+    for(unsigned int t=0; t<nbTriangles; t++){
+        for(unsigned int j=0; j<3; j++){
+            uint64_t a = triangles[t].getVertex(j);
+            uint64_t b = triangles[t].getVertex((j+1)%3);
+            if(a > b) std::swap(a, b);
+            halfEdges.push_back(std::make_pair((a << 32) | b, t*3 + j));
+        }
+    }
+    std::sort(halfEdges.begin(), halfEdges.end());
+
+    std::vector<unsigned int> edgeVertex(static_cast<size_t>(nbTriangles)*3);      // the new vertex on each half edge
+    std::vector<Vec3Df> newVertices;
+    std::vector<Vec3Df> neighbourSum;
+    std::vector<unsigned int> valence;
+    std::vector<bool> isBoundary;
+    if(method == LOOP){
+        neighbourSum.assign(nbVertices, Vec3Df(0, 0, 0));
+        valence.assign(nbVertices, 0);
+        isBoundary.assign(nbVertices, false);
+    }
+
+    size_t i = 0;
+    while(i < halfEdges.size()){
+        size_t end = i+1;
+        while(end < halfEdges.size() && halfEdges[end].first == halfEdges[i].first) end++;
+
+        const unsigned int a = static_cast<unsigned int>(halfEdges[i].first >> 32);
+        const unsigned int b = static_cast<unsigned int>(halfEdges[i].first & 0xffffffff);
+        Vec3Df p = (vertices[a] + vertices[b]) * 0.5f;
+
+        if(method == LOOP){
+            if(end - i == 2){       // an inside edge : 3/8 of its ends and 1/8 of the two opposite verticies
+                const unsigned int h0 = halfEdges[i].second, h1 = halfEdges[i+1].second;
+                const unsigned int c = triangles[h0/3].getVertex((h0%3 + 2)%3);
+                const unsigned int d = triangles[h1/3].getVertex((h1%3 + 2)%3);
+                p = (vertices[a] + vertices[b]) * 0.375f + (vertices[c] + vertices[d]) * 0.125f;
+            }
+            else{       // a boundary (or non manifold) edge stays straight
+                isBoundary[a] = true;
+                isBoundary[b] = true;
+            }
+            neighbourSum[a] += vertices[b];
+            neighbourSum[b] += vertices[a];
+            valence[a]++;
+            valence[b]++;
+        }
+
+        const unsigned int index = nbVertices + static_cast<unsigned int>(newVertices.size());
+        newVertices.push_back(p);
+        for(size_t k=i; k<end; k++) edgeVertex[halfEdges[k].second] = index;
+        i = end;
+    }
+    std::vector<std::pair<uint64_t, unsigned int>>().swap(halfEdges);       // free it before the triangles grow
+
+    if(method == LOOP){
+        for(unsigned int v=0; v<nbVertices; v++){
+            const unsigned int n = valence[v];
+            if(isBoundary[v] || n < 3) continue;
+            const float beta = n==3 ? 3.0f/16.0f : 3.0f/(8.0f*n);
+            vertices[v] = vertices[v] * (1.0f - n*beta) + neighbourSum[v] * beta;
+        }
+    }
+    vertices.insert(vertices.end(), newVertices.begin(), newVertices.end());
+
+    triangles.resize(static_cast<size_t>(nbTriangles)*4);
+    for(unsigned int t=0; t<nbTriangles; t++){
+        const Triangle old = triangles[t];
+        const unsigned int m01 = edgeVertex[t*3], m12 = edgeVertex[t*3+1], m20 = edgeVertex[t*3+2];
+        triangles[t] = Triangle(m01, m12, m20);
+        triangles[nbTriangles + t*3] = Triangle(old.getVertex(0), m01, m20);
+        triangles[nbTriangles + t*3 + 1] = Triangle(old.getVertex(1), m12, m01);
+        triangles[nbTriangles + t*3 + 2] = Triangle(old.getVertex(2), m20, m12);
+    }
+}
+
+void tile(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles, unsigned int nbCopies){
+    if(nbCopies < 2) return;
+
+    float minX = FLT_MAX, maxX = -FLT_MAX;
+    for(size_t v=0; v<vertices.size(); v++){
+        minX = std::min(minX, vertices[v][0]);
+        maxX = std::max(maxX, vertices[v][0]);
+    }
+    const float step = (maxX - minX) * 1.1f;
+
+    const size_t nbVertices = vertices.size();
+    const size_t nbTriangles = triangles.size();
+    vertices.reserve(nbVertices * nbCopies);
+    triangles.reserve(nbTriangles * nbCopies);
+    for(unsigned int c=1; c<nbCopies; c++){
+        const Vec3Df offset(step * c, 0, 0);
+        const unsigned int first = static_cast<unsigned int>(vertices.size());
+        for(size_t v=0; v<nbVertices; v++) vertices.push_back(vertices[v] + offset);
+        for(size_t t=0; t<nbTriangles; t++) triangles.push_back(Triangle(first + triangles[t].getVertex(0), first + triangles[t].getVertex(1), first + triangles[t].getVertex(2)));
+    }
+}
+
+void jitter(std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, float amount, unsigned int seed){
+    if(triangles.size() == 0) return;
+
+    double length = 0;
+    for(size_t t=0; t<triangles.size(); t++){
+        for(unsigned int j=0; j<3; j++) length += (vertices[triangles[t].getVertex(j)] - vertices[triangles[t].getVertex((j+1)%3)]).norm();
+    }
+    const float radius = amount * static_cast<float>(length / (triangles.size()*3));
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> random(-1.0f, 1.0f);
+    for(size_t v=0; v<vertices.size(); v++){
+        Vec3Df d;
+        do{ d = Vec3Df(random(generator), random(generator), random(generator)); } while(d.getSquaredLength() > 1.0f);     // inside the unit ball
+        vertices[v] += d * radius;
+    }
+}
+
+}
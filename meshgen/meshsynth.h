@@ -0,0 +1,23 @@
+#ifndef MESHSYNTH_H
+#define MESHSYNTH_H
+
+#include "Vec3D.h"
+#include "Triangle.h"
+#include <vector>
+
+// Ways of making a bigger mesh out of a real one, to see how the planning scales
+namespace MeshSynth{
+    enum Method {MIDPOINT, LOOP};
+
+    // Each triangle becomes 4 : the new verticies are on the middle of the edges (MIDPOINT) or use Loop's weights,
+    // which also move the old verticies (the boundary verticies and edges stay where they are)
+    void subdivide(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles, Method method);
+
+    // nbCopies side by side along x, one bounding box apart (the first copy doesn't move)
+    void tile(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles, unsigned int nbCopies);
+
+    // Moves every vertex randomly by up to amount times the average edge length
+    void jitter(std::vector<Vec3Df> &vertices, const std::vector<Triangle> &triangles, float amount, unsigned int seed);
+}
+
+#endif // MESHSYNTH_H
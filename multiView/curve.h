@@ -3,9 +3,11 @@
 
 #include <QGLViewer/qglviewer.h>
 #include "controlpoint.h"
+#include "curvegeometry.h"
 
 using namespace qglviewer;
 
+// Keeps the curve geometry in step with the control points and draws it
 class Curve : public QObject
 {
     Q_OBJECT
@@ -15,59 +17,59 @@ public:
 
     void generateBSpline(unsigned int& nbU, unsigned int degree);
     void generateCatmull(unsigned int& nbU);
+    void generateAdaptiveCatmull(double chordError, double maxSpacing, unsigned int& nbU);    // as many samples as needed to stay within chordError of the curve (and no further than maxSpacing apart)
+
+    const CurveGeometry& getGeometry(){ return geometry; }      // for the planning which doesn't need Qt
 
     std::vector<Vec>& getCurve(){ return curve; }
     Vec& getPoint(unsigned int index){ return curve[index]; }
     unsigned int& getNbU(){ return nbU; }
 
-    Vec tangent(unsigned int index);
-    Vec normal(unsigned int index);
-    Vec binormal(unsigned int index);
+    Vec tangent(unsigned int index){ return toVec(geometry.tangent(index)); }
+    Vec normal(unsigned int index){ return toVec(geometry.normal(index)); }
+    Vec binormal(unsigned int index){ return toVec(geometry.binormal(index)); }
     void getFrame(unsigned int index, Vec& t, Vec& n, Vec& b);
 
+    // Rotation minimising frames : x is the normal, z the tangent (no flips at the inflections unlike the Frenet frame)
+    const Quaternion& getOrientation(unsigned int index){ return frameOrientations[index]; }
+    Vec getFrameNormal(unsigned int index){ return toVec(geometry.getFrameNormal(index)); }
+    double getTurningRate(unsigned int index){ return geometry.getTurningRate(index); }     // how much the tangent turns between the previous sample and this one (radians per mm)
+
+    void reportMemory(MemoryReport &report) const;      // the geometry and the copies for the viewers
+
     void draw();
     void drawControl();
     void drawTangent(unsigned int index);
 
-    double discreteLength(unsigned int indexS, unsigned int indexE);      // Returns the discrete length between 2 points (Straight line distance)
-    double discreteChordLength(unsigned int indexS, unsigned int indexE); // To use for the initial visualisation
-    unsigned int indexForLength(unsigned int indexS, double length);   // Returns the end index which will create a segment of a certain length
+    double discreteLength(unsigned int indexS, unsigned int indexE){ return geometry.discreteLength(indexS, indexE); }      // Returns the discrete length between 2 points (Straight line distance)
+    double discreteChordLength(unsigned int indexS, unsigned int indexE){ return geometry.discreteChordLength(indexS, indexE); } // To use for the initial visualisation
+    unsigned int indexForLength(unsigned int indexS, double length){ return geometry.indexForLength(indexS, length); }   // Returns the end index which will create a segment of a certain length
+    double getTotalLength(){ return geometry.getTotalLength(); }
+    double lengthAtIndex(unsigned int index){ return geometry.lengthAtIndex(index); }      // the length along the curve from the first sample
+    unsigned int indexAtLength(double length){ return geometry.indexAtLength(length); }      // the closest sample to a length along the curve
 
 public Q_SLOTS:
     void reintialiseCurve();
+    void controlPointMoved(unsigned int index);     // only regenerates the segments which depend on this control point
 
 Q_SIGNALS:
-    void curveReinitialised();
+    void curveReinitialised(unsigned int start, unsigned int end);     // the samples [start, end) have moved or turned
 
 private:
-    std::vector<ControlPoint*> TabControlPoint;
-    unsigned int nbControlPoint;
-    std::vector<Vec> curve;
-    unsigned int nbU;
-
-    unsigned int degree;
-    std::vector<double> knotVector;
-    unsigned int knotIndex;
-
-    // BSpline
-    void generateUniformKnotVector(unsigned int k, std::vector<double>& kv);
-    Vec deBoor(double u, unsigned int i, unsigned int r);
-    void splineDerivative(unsigned int k, std::vector<Vec> &c);
-    Vec deBoorDerivative(double u, unsigned int i, unsigned int r, unsigned int k);
-
-    // Catmull rom
-    void catmullrom();  // calculate the spline and the first derivative
-    void calculateCatmullPoints(Vec& c, Vec& cp, Vec& cpp, double t);
-
-    void generateCatmullKnotVector(double alpha, std::vector<double>& knotV);
+    static Vec toVec(const Vec3Dd &v){ return Vec(v[0], v[1], v[2]); }
+    static Vec3Dd toVec3D(const Vec &v){ return Vec3Dd(v.x, v.y, v.z); }
 
     void initConnections();
+    void sync(unsigned int start = 0);      // copy the samples from start onwards out of the geometry
 
-    unsigned int getClosestDistance(double target, unsigned int indexS, unsigned int a, unsigned int b);       // get the index which is closest to the target distance
+    std::vector<ControlPoint*> TabControlPoint;
+    unsigned int nbControlPoint;
+    CurveGeometry geometry;
 
-    // Frenet frame
-    std::vector<Vec> dt;
-    std::vector<Vec> d2t;
+    // Copies of the geometry's samples for the viewers
+    std::vector<Vec> curve;
+    unsigned int nbU;
+    std::vector<Quaternion> frameOrientations;
 };
 
 #endif // CURVE_H
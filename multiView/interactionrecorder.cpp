@@ -0,0 +1,119 @@
+#include "interactionrecorder.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <iostream>
+
+void InteractionRecorder::addSlider(const QString &name, QSlider *slider){
+    connect(slider, &QSlider::sliderMoved, this, [this, name](int value){
+        TraceEvent e;
+        e.name = name;
+        e.value = value;
+        record(e);
+    });
+    connect(slider, &QSlider::sliderReleased, this, [this, name](){
+        TraceEvent e;
+        e.name = "release";
+        e.source = name;
+        record(e);
+    });
+}
+
+void InteractionRecorder::start(){
+    events.clear();
+    clock.start();
+    isActive = true;
+}
+
+void InteractionRecorder::record(TraceEvent e){
+    if(!isActive) return;
+    e.time = static_cast<double>(clock.nsecsElapsed()) / 1e6;
+    events.push_back(e);
+}
+
+void InteractionRecorder::recordOpen(const QString &viewer, const QString &fileName){
+    TraceEvent e;
+    e.name = "open";
+    e.source = viewer;
+    e.file = fileName;
+    record(e);
+}
+
+void InteractionRecorder::recordCut(int nbPieces){
+    TraceEvent e;
+    e.name = "cutIntoPieces";
+    e.value = nbPieces;
+    record(e);
+}
+
+void InteractionRecorder::recordUncut(){
+    TraceEvent e;
+    e.name = "uncutMesh";
+    record(e);
+}
+
+void InteractionRecorder::recordPlaneManipulated(unsigned int index, Vec position){
+    TraceEvent e;
+    e.name = "ghostPlaneMoved";
+    e.value = static_cast<int>(index);
+    e.position = position;
+    record(e);
+}
+
+bool InteractionRecorder::save(const QString &fileName) const{
+    QJsonArray array;
+    for(unsigned int i=0; i<events.size(); i++){
+        const TraceEvent &e = events[i];
+        QJsonObject o;
+        o["t"] = e.time;
+        o["event"] = e.name;
+        if(!e.source.isEmpty()) o["source"] = e.source;
+        if(!e.file.isEmpty()) o["file"] = e.file;
+        if(e.name != "release" && e.name != "open" && e.name != "uncutMesh") o["value"] = e.value;
+        if(e.name == "ghostPlaneMoved") o["position"] = QJsonArray({e.position.x, e.position.y, e.position.z});
+        array.append(o);
+    }
+
+    QJsonObject trace;
+    trace["events"] = array;
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly)){
+        std::cout << fileName.toStdString() << " cannot be opened" << std::endl;
+        return false;
+    }
+    file.write(QJsonDocument(trace).toJson());
+    std::cout << events.size() << " interactions saved in " << fileName.toStdString() << std::endl;
+    return true;
+}
+
+bool InteractionRecorder::load(const QString &fileName, std::vector<TraceEvent> &events){
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)){
+        std::cout << fileName.toStdString() << " cannot be opened" << std::endl;
+        return false;
+    }
+
+    const QJsonObject trace = QJsonDocument::fromJson(file.readAll()).object();
+    if(!trace.contains("events") || !trace["events"].isArray()){
+        std::cout << fileName.toStdString() << " isn't an interaction trace" << std::endl;
+        return false;
+    }
+
+    events.clear();
+    const QJsonArray array = trace["events"].toArray();
+    for(int i=0; i<array.size(); i++){
+        const QJsonObject o = array[i].toObject();
+        TraceEvent e;
+        e.time = o["t"].toDouble();
+        e.name = o["event"].toString();
+        e.source = o["source"].toString();
+        e.file = o["file"].toString();
+        e.value = o["value"].toInt();
+        const QJsonArray p = o["position"].toArray();
+        if(p.size() == 3) e.position = Vec(p[0].toDouble(), p[1].toDouble(), p[2].toDouble());
+        events.push_back(e);
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef INTERACTIONRECORDER_H
+#define INTERACTIONRECORDER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSlider>
+#include <QGLViewer/qglviewer.h>
+#include <vector>
+
+using namespace qglviewer;
+
+// One user action : a slider moved or released, a plane dragged, a file opened, a cut
+struct TraceEvent{
+    double time = 0;        // ms since the recording started
+    QString name;       // the slider's slot (moveLeftPlane...), "release", "ghostPlaneMoved", "open", "cutIntoPieces" or "uncutMesh"
+    QString source;     // the slider released, or the viewer a file was opened in ("mandible" / "fibula")
+    int value = 0;      // the slider value, the plane dragged or the number of pieces
+    Vec position;       // where the plane was dragged to
+    QString file;
+};
+
+/*
+ * Records what the user does with the sliders and the planes so a slow session can be replayed (see TraceReplayer).
+ * The trace is a JSON file : {"events": [{"t": 12.5, "event": "moveLeftPlane", "value": 420}, ...]}
+*/
+class InteractionRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    InteractionRecorder(QObject *parent = nullptr) : QObject(parent){}
+
+    void addSlider(const QString &name, QSlider *slider);       // name is the slot the slider drives
+    void start();
+    bool isRecording() const { return isActive; }
+    bool save(const QString &fileName) const;
+
+    static bool load(const QString &fileName, std::vector<TraceEvent> &events);
+
+public Q_SLOTS:
+    void recordOpen(const QString &viewer, const QString &fileName);
+    void recordCut(int nbPieces);
+    void recordUncut();
+    void recordPlaneManipulated(unsigned int index, Vec position);
+
+private:
+    void record(TraceEvent e);
+
+    QElapsedTimer clock;
+    bool isActive = false;
+    std::vector<TraceEvent> events;
+};
+
+#endif // INTERACTIONRECORDER_H
@@ -1,11 +1,42 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include "trace.h"
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // --record saves what the user does, --replay plays it back and reports the latencies
+    // (with -platform offscreen the replay needs no display)
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"record", "Record the interactions in <file>.", "file"});
+    parser.addOption({"replay", "Replay the interactions in <file> then quit.", "file"});
+    parser.addOption({"report", "Save the replay latencies in <file> (csv) instead of printing them.", "file"});
+    parser.addOption({"speed", "Replay <x> times faster than recorded.", "x", "1"});
+    parser.addOption({"trace", "Save the hot path timings in <file> (Chrome trace) when quitting, needs CONFIG+=tracing.", "file"});
+    parser.process(a);
+    if(Trace::isEnabled()) Trace::setThreadName("main");
+
     MainWindow w;
     w.show();
 
-    return a.exec();
+    if(parser.isSet("record")) w.startRecording(parser.value("record"));
+    if(parser.isSet("replay")){
+        const double speed = parser.value("speed").toDouble();
+        int result = 0;
+        QTimer::singleShot(0, [&](){
+            result = w.replay(parser.value("replay"), parser.value("report"), speed > 0 ? speed : 1.0);
+            a.quit();
+        });
+        a.exec();
+        if(parser.isSet("trace")) Trace::save(parser.value("trace").toStdString());
+        return result;
+    }
+
+    const int result = a.exec();
+    if(parser.isSet("trace")) Trace::save(parser.value("trace").toStdString());
+    return result;
 }
@@ -5,6 +5,16 @@
 #include <QSlider>
 #include <QFormLayout>
 #include <QPushButton>
+#include <QDialog>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QInputDialog>
+#include <QLabel>
+#include "piececountevaluator.h"
+#include "tracereplayer.h"
+#include "trace.h"
+#include <iostream>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -26,6 +36,11 @@ MainWindow::MainWindow(QWidget *parent)
     StandardCamera *scFibula = new StandardCamera();
     fibulaViewer = new ViewerFibula(this, scFibula, sliderMax, fibulaOffsetMax);
 
+    // Cuts both meshes once the mandible has sent its planes
+    pipeline = new PlanningPipeline(skullViewer, fibulaViewer);
+
+    recorder = new InteractionRecorder(this);
+
     // Main widget
     QWidget *mainWidget = new QWidget(this);
     //QWidget *fibulaWidget = new QWidget(this);
@@ -60,7 +75,7 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-
+    if(recorder->isRecording()) recorder->save(traceFile);
 }
 
 void MainWindow::initDisplayDockWidgets(){
@@ -104,6 +119,12 @@ void MainWindow::initDisplayDockWidgets(){
     rightPlaneRotationSlider->setMaximum(sliderMax);
     contentLayoutMand->addRow("Right rotation", rightPlaneRotationSlider);
 
+    sliders["moveLeftPlane"] = leftPlaneSlider;
+    sliders["moveRightPlane"] = rightPlaneSlider;
+    sliders["setAlpha"] = planeAlphaSlider;
+    sliders["rotateLeftPlane"] = leftPlaneRotationSlider;
+    sliders["rotateRightPlane"] = rightPlaneRotationSlider;
+
     // Connect the skull sliders
     connect(leftPlaneSlider, static_cast<void (QSlider::*)(int)>(&QSlider::sliderMoved), skullViewer, &Viewer::moveLeftPlane);
     connect(rightPlaneSlider, static_cast<void (QSlider::*)(int)>(&QSlider::sliderMoved), skullViewer, &Viewer::moveRightPlane);
@@ -133,6 +154,8 @@ void MainWindow::initDisplayDockWidgets(){
     fibTransparencySlider->setMaximum(100);
     fibTransparencySlider->setSliderPosition(100);*/
 
+    sliders["movePlanes"] = fibulaSlider;
+
     // Connect the fibula slider
     connect(fibulaSlider, static_cast<void (QSlider::*)(int)>(&QSlider::sliderMoved), fibulaViewer, &ViewerFibula::movePlanes);
     connect(fibulaSlider, &QSlider::sliderReleased, fibulaViewer, &ViewerFibula::planesMoved);
@@ -150,6 +173,7 @@ void MainWindow::initDisplayDockWidgets(){
 
     connect(skullViewer, &Viewer::noGhostPlanesToSend, fibulaViewer, &ViewerFibula::noGhostPlanesToRecieve);
     connect(skullViewer, &Viewer::preparingToCut, fibulaViewer, &ViewerFibula::uncutMesh);
+    connect(skullViewer, &Viewer::preparingToCut, pipeline, &PlanningPipeline::prepare);
 
     // Move the planes so tempory mesh cut
     connect(skullViewer, &Viewer::ghostPlaneMovementStart, fibulaViewer, &ViewerFibula::uncutMesh);
@@ -157,6 +181,11 @@ void MainWindow::initDisplayDockWidgets(){
     connect(fibulaViewer, &ViewerFibula::requestAxes, skullViewer, &Viewer::getAxes);
     connect(skullViewer, &Viewer::sendAxes, fibulaViewer, &ViewerFibula::recieveAxes);
 
+    // What the user does, for the interaction traces
+    for(auto it = sliders.begin(); it != sliders.end(); ++it) recorder->addSlider(it.key(), it.value());
+    connect(skullViewer, &Viewer::planeManipulated, recorder, &InteractionRecorder::recordPlaneManipulated);
+    connect(skullViewer, &Viewer::cutRequested, recorder, &InteractionRecorder::recordCut);
+
     contentsMand->setLayout(contentLayoutMand);
     contentsFibula->setLayout(contentLayoutFibula);
 
@@ -173,6 +202,7 @@ void MainWindow::initDisplayDockWidgets(){
 
 void MainWindow::initFileActions(){
     fileActionGroup = new QActionGroup(this);
+    fileActionGroup->setExclusive(false);       // so the checkable actions can be unchecked
 
     /*QAction *openFileSkullAction = new QAction("Open skull mesh", this);
     connect(openFileSkullAction, &QAction::triggered, this, &MainWindow::openSkullMesh);
@@ -182,11 +212,12 @@ void MainWindow::initFileActions(){
 
     QAction *cutMeshAction = new QAction("Cut", this);
     connect(cutMeshAction, &QAction::triggered, skullViewer, &Viewer::cutMesh);
-    connect(skullViewer, &Viewer::okToCut, fibulaViewer, &ViewerFibula::cutMesh);
+    connect(skullViewer, &Viewer::okToCut, pipeline, &PlanningPipeline::run);
 
     QAction *unCutMeshAction = new QAction("Undo cut", this);
     connect(unCutMeshAction, &QAction::triggered, skullViewer, &Viewer::uncutMesh);
     connect(unCutMeshAction, &QAction::triggered, fibulaViewer, &ViewerFibula::uncutMesh);
+    connect(unCutMeshAction, &QAction::triggered, recorder, &InteractionRecorder::recordUncut);
 
     QAction *drawMeshAction = new QAction("Toggle draw mesh", this);
     connect(drawMeshAction, &QAction::triggered, skullViewer, &Viewer::drawMesh);
@@ -196,6 +227,13 @@ void MainWindow::initFileActions(){
     connect(drawPlaneAction, &QAction::triggered, skullViewer, &Viewer::toggleIsDrawPlane);
     connect(drawPlaneAction, &QAction::triggered, fibulaViewer, &ViewerFibula::toggleIsDrawPlane);
 
+    QAction *optimisePlanAction = new QAction("Optimise plan", this);
+    optimisePlanAction->setCheckable(true);
+    connect(optimisePlanAction, &QAction::toggled, skullViewer, &Viewer::setOptimisePlan);
+
+    QAction *comparePiecesAction = new QAction("Compare piece counts", this);
+    connect(comparePiecesAction, &QAction::triggered, this, &MainWindow::comparePieceCounts);
+
     QAction *openJsonFileAction = new QAction("Open mandible JSON", this);
     connect(openJsonFileAction, &QAction::triggered, this, &MainWindow::openMandJSON);
 
@@ -208,9 +246,31 @@ void MainWindow::initFileActions(){
     //fileActionGroup->addAction(openFileFibulaAction);
     fileActionGroup->addAction(unCutMeshAction);
     fileActionGroup->addAction(cutMeshAction);
+    fileActionGroup->addAction(optimisePlanAction);
+    fileActionGroup->addAction(comparePiecesAction);
     fileActionGroup->addAction(drawMeshAction);
     fileActionGroup->addAction(drawPlaneAction);
 
+    QAction *perfHudAction = new QAction("Toggle performance HUD", this);
+    connect(perfHudAction, &QAction::triggered, skullViewer, &Viewer::togglePerfHud);
+    connect(perfHudAction, &QAction::triggered, fibulaViewer, &ViewerFibula::togglePerfHud);
+
+    QAction *frameBudgetAction = new QAction("Set frame budget", this);
+    connect(frameBudgetAction, &QAction::triggered, this, &MainWindow::setFrameBudget);
+
+    QAction *memoryReportAction = new QAction("Memory report", this);
+    connect(memoryReportAction, &QAction::triggered, this, &MainWindow::showMemoryReport);
+
+    fileActionGroup->addAction(perfHudAction);
+    fileActionGroup->addAction(frameBudgetAction);
+    fileActionGroup->addAction(memoryReportAction);
+
+    if(Trace::isEnabled()){
+        QAction *saveTraceAction = new QAction("Save trace", this);
+        connect(saveTraceAction, &QAction::triggered, this, &MainWindow::saveTrace);
+        fileActionGroup->addAction(saveTraceAction);
+    }
+
 }
 
 void MainWindow::initFileMenu(){
@@ -272,7 +332,13 @@ void MainWindow::openJSON(Viewer *v){
 
     QString fileFilter = "JSON (*.json)";
     QString filename = QFileDialog::getOpenFileName(this, tr("Select a mesh"), openFileNameLabel, fileFilter, &selectedFilter);
+    if(filename.isEmpty()) return;
+
+    openJSONFile(filename, v);
+}
 
+void MainWindow::openJSONFile(const QString &filename, Viewer *v){
+    recorder->recordOpen(v==skullViewer ? "mandible" : "fibula", filename);
 
     QFile loadFile(filename);
 
@@ -295,4 +361,145 @@ void MainWindow::openFibJSON(){
     openJSON(fibulaViewer);
 }
 
+// Plan every number of pieces in the background and let the user pick one from the table
+void MainWindow::comparePieceCounts(){
+    Curve *mandible = skullViewer->getCurve();
+    Curve *fibula = fibulaViewer->getCurve();
+    if(!mandible || !fibula){
+        QMessageBox::information(this, "Compare piece counts", "Open both the mandible and the fibula first.");
+        return;
+    }
+
+    const unsigned int maxPieces = 10;
+    PieceCountEvaluator evaluator(mandible->getGeometry(), skullViewer->getCurveIndexL(), skullViewer->getCurveIndexR(), fibula->getGeometry(), fibulaViewer->getCurveIndexL(), fibulaViewer->mesh.getVertices(), skullViewer->getConstraint(), fibulaViewer->getSecurityMargin(), skullViewer->getIsOptimisePlan());
+    std::vector<PieceCountEvaluator::PlanSummary> summaries = evaluator.evaluate(maxPieces, ThreadPool::global());
+    PieceCountEvaluator::rank(summaries);
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Compare piece counts");
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+
+    QTableWidget *table = new QTableWidget(static_cast<int>(summaries.size()), 7, &dialog);
+    table->setHorizontalHeaderLabels({"Pieces", "Placed", "RMS deviation (mm)", "Max deviation (mm)", "Fibula used (mm)", "Approach (mm)", "Time (ms)"});
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setSelectionMode(QAbstractItemView::SingleSelection);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->hide();
+
+    for(unsigned int i=0; i<summaries.size(); i++){
+        const PieceCountEvaluator::PlanSummary &s = summaries[i];
+        const int row = static_cast<int>(i);
+        table->setItem(row, 0, new QTableWidgetItem(QString::number(s.nbPieces)));
+        table->setItem(row, 1, new QTableWidgetItem(QString::number(s.nbPlaced)));
+        table->setItem(row, 2, new QTableWidgetItem(QString::number(s.rmsDeviation, 'f', 2)));
+        table->setItem(row, 3, new QTableWidgetItem(QString::number(s.maxDeviation, 'f', 2)));
+        table->setItem(row, 4, new QTableWidgetItem(s.isOnFibula ? QString::number(s.fibulaLength, 'f', 1) : QString("too long")));
+        table->setItem(row, 5, new QTableWidgetItem(QString::number(s.approachShift, 'f', 1)));
+        table->setItem(row, 6, new QTableWidgetItem(QString::number(s.duration, 'f', 1)));
+    }
+    table->resizeColumnsToContents();
+    table->selectRow(0);
+    layout->addWidget(table);
+
+    QPushButton *useButton = new QPushButton("Use selected", &dialog);
+    connect(useButton, &QPushButton::clicked, &dialog, &QDialog::accept);
+    layout->addWidget(useButton);
+
+    dialog.resize(table->horizontalHeader()->length() + 40, 400);
+    if(dialog.exec() != QDialog::Accepted || table->currentRow() < 0) return;
+
+    skullViewer->cutIntoPieces(static_cast<int>(summaries[static_cast<unsigned int>(table->currentRow())].nbPieces));
+}
+
+void MainWindow::setFrameBudget(){
+    bool isNumberRecieved;
+    double budget = QInputDialog::getDouble(this, "Performance HUD", "Frame budget (ms)", frameBudget, 1, 1000, 1, &isNumberRecieved);
+    if(!isNumberRecieved) return;
+
+    frameBudget = budget;
+    skullViewer->setFrameBudget(budget);
+    fibulaViewer->setFrameBudget(budget);
+}
+
+void MainWindow::showMemoryReport(){
+    MemoryReport mandible, fibula, report;
+    skullViewer->reportMemory(mandible);
+    fibulaViewer->reportMemory(fibula);
+    report.add("mandible.", mandible);
+    report.add("fibula.", fibula);
+    report.print(std::cout);
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Memory report");
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+
+    const std::vector<MemoryReport::Buffer> &buffers = report.getBuffers();
+    QTableWidget *table = new QTableWidget(static_cast<int>(buffers.size()), 4, &dialog);
+    table->setHorizontalHeaderLabels({"Buffer", "Elements", "Used (KB)", "Allocated (KB)"});
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->hide();
+
+    for(unsigned int i=0; i<buffers.size(); i++){
+        const int row = static_cast<int>(i);
+        table->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(buffers[i].name)));
+        table->setItem(row, 1, new QTableWidgetItem(QString::number(buffers[i].nbElements)));
+        table->setItem(row, 2, new QTableWidgetItem(QString::number(static_cast<double>(buffers[i].usedBytes) / 1024., 'f', 1)));
+        table->setItem(row, 3, new QTableWidgetItem(QString::number(static_cast<double>(buffers[i].allocatedBytes) / 1024., 'f', 1)));
+    }
+    table->resizeColumnsToContents();
+    layout->addWidget(table);
+
+    QString total = QString("%1 MB used, %2 MB allocated").arg(static_cast<double>(report.getUsedBytes()) / (1024.*1024.), 0, 'f', 1).arg(static_cast<double>(report.getAllocatedBytes()) / (1024.*1024.), 0, 'f', 1);
+    if(MemoryTracker::isEnabled()) total += QString(", peak of the process %1 MB").arg(static_cast<double>(MemoryTracker::getPeakBytes()) / (1024.*1024.), 0, 'f', 1);
+    layout->addWidget(new QLabel(total, &dialog));
+
+    dialog.resize(table->horizontalHeader()->length() + 40, 500);
+    dialog.exec();
+}
 
+void MainWindow::saveTrace(){
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save trace"), "trace.json", "JSON (*.json)");
+    if(!fileName.isEmpty()) Trace::save(fileName.toStdString());
+}
+
+void MainWindow::startRecording(const QString &fileName){
+    traceFile = fileName;
+    recorder->start();
+}
+
+// Does what the user did when the event was recorded
+void MainWindow::dispatch(const TraceEvent &e){
+    if(sliders.contains(e.name)){
+        QSlider *slider = sliders[e.name];
+        slider->setValue(e.value);
+        Q_EMIT slider->sliderMoved(e.value);
+    }
+    else if(e.name == "release"){
+        if(sliders.contains(e.source)) Q_EMIT sliders[e.source]->sliderReleased();
+    }
+    else if(e.name == "ghostPlaneMoved") skullViewer->manipulatePlane(static_cast<unsigned int>(e.value), e.position);
+    else if(e.name == "cutIntoPieces") skullViewer->cutIntoPieces(e.value);
+    else if(e.name == "uncutMesh"){
+        skullViewer->uncutMesh();
+        fibulaViewer->uncutMesh();
+    }
+    else if(e.name == "open") openJSONFile(e.file, e.source=="fibula" ? static_cast<Viewer*>(fibulaViewer) : skullViewer);
+    else std::cout << "Unknown event in the trace : " << e.name.toStdString() << std::endl;
+}
+
+int MainWindow::replay(const QString &traceFile, const QString &reportFile, double speed){
+    std::vector<TraceEvent> events;
+    if(!InteractionRecorder::load(traceFile, events)) return 1;
+
+    TraceReplayer replayer(events, [this](const TraceEvent &e){ dispatch(e); }, speed);
+    replayer.addGraph("mandible", skullViewer->mesh.getCutGraph());
+    replayer.addGraph("fibula", fibulaViewer->mesh.getCutGraph());
+    replayer.addGraph("pipeline", pipeline->getLastRun());
+    replayer.addView(skullViewer);
+    replayer.addView(fibulaViewer);
+    replayer.run();
+
+    if(reportFile.isEmpty()) replayer.printReport(std::cout);
+    else if(!replayer.saveReport(reportFile)) return 1;
+    return 0;
+}
@@ -2,7 +2,10 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QMap>
 #include "viewerfibula.h"
+#include "planningpipeline.h"
+#include "interactionrecorder.h"
 
 class MainWindow : public QMainWindow
 {
@@ -12,10 +15,14 @@ public:
     MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
+    void startRecording(const QString &fileName);      // saved when the window closes
+    int replay(const QString &traceFile, const QString &reportFile, double speed);     // plays a recorded trace and reports the latencies
+
 private:
     // Main viewers
     Viewer *skullViewer;
     ViewerFibula *fibulaViewer;
+    PlanningPipeline *pipeline;
     QDockWidget *skullDockWidget;
     void initDisplayDockWidgets();
 
@@ -28,12 +35,25 @@ private:
     // Reading
     void readJSON(const QJsonObject &json, Viewer *v);
     void openJSON(Viewer* v);
+    void openJSONFile(const QString &fileName, Viewer *v);
+
+    // Interaction traces
+    QMap<QString, QSlider*> sliders;        // by the slot they drive
+    InteractionRecorder *recorder;
+
+    double frameBudget = 1000. / 60.;       // ms, for the performance HUD
+    QString traceFile;
+    void dispatch(const TraceEvent &e);
 
 private Q_SLOTS:
     void openSkullMesh();
     void openFibulaMesh();
     void openMandJSON();
     void openFibJSON();
+    void setFrameBudget();
+    void showMemoryReport();        // the bytes held by each buffer of both viewers
+    void saveTrace();       // the hot path timings, for chrome://tracing or Perfetto
+    void comparePieceCounts();
 
 private:
     int sliderMax;
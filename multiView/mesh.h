@@ -1,32 +1,29 @@
 #ifndef MESH_H
 #define MESH_H
 
-#include "Vec3D.h"
-#include "Triangle.h"
+#include "meshgeometry.h"
 #include "plane.h"
+#include "taskgraph.h"
+#include "stagetimings.h"
+#include <functional>
 #include <queue>
 
-enum Side {INTERIOR, EXTERIOR};
-
-class Mesh : public QObject
+// Draws the mesh geometry and keeps it cut with the viewer's planes
+class Mesh : public QObject, public MeshGeometry
 {
     Q_OBJECT
 
 public:
 
-    Mesh():normalDirection(1.){}
-    Mesh(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles): vertices(vertices), triangles(triangles), normalDirection(1.){
+    static const size_t cutCacheBytes = 32 << 20;      // the cuts kept to go back to when the sliders are scrubbed
+
+    Mesh():normalDirection(1.){ setCutCacheSize(cutCacheBytes); }
+    Mesh(std::vector<Vec3Df> &vertices, std::vector<Triangle> &triangles): MeshGeometry(vertices, triangles), normalDirection(1.){
+        setCutCacheSize(cutCacheBytes);
         update();
     }
     ~Mesh(){}
     void init();
-    void computeBB(Vec3Df &centre, float& radius);
-
-    std::vector<Vec3Df> &getVertices(){return vertices;}
-    const std::vector<Vec3Df> &getVertices()const {return vertices;}
-
-    std::vector<Triangle> &getTriangles(){return triangles;}
-    const std::vector<Triangle> &getTriangles()const {return triangles;}
 
     std::vector<unsigned int> getVerticesOnPlane(unsigned int planeNb, Plane *p);
     Triangle& getTriangle(unsigned int i){ return triangles[i]; }
@@ -34,12 +31,18 @@ public:
 
     void draw();
 
-    void recomputeNormals();
     void update();
     void clear();
 
     void updatePlaneIntersections();    // need one for a single plane
     void updatePlaneIntersections(Plane *p);
+    void addCutTasks(TaskGraph &graph, const std::string &prefix, unsigned int &first, unsigned int &last);    // the cutting stages, from the intersections to the smoothing
+    void publishCut();      // the stage which has to stay on the main thread (signals)
+    void setDeferred(bool isDeferred){ this->isDeferred = isDeferred; }     // while deferred the updates are only recorded, the planning pipeline runs them
+    TaskGraph& getCutGraph(){ return cutGraph; }
+    StageTimings& getTimings(){ return timings; }       // the cutting stages which had something to do
+    unsigned int getNbDroppedUpdates() const { return nbDroppedUpdates; }      // updates replaced by a newer one before they were run
+    void reportMemory(MemoryReport &report) const;      // the geometry and the fibula copies in the mandible
 
     void addPlane(Plane *p);
     void deleteGhostPlanes();
@@ -63,51 +66,26 @@ Q_SIGNALS:
     void updateViewer();
 
 protected:
-    Vec3Df computeTriangleNormal(unsigned int t);
-    void computeVerticesNormals();
     void glTriangle(unsigned int i);
     void glTriangleSmooth(unsigned int i, std::vector <int> &coloursIndicies);
     void glTriangleFibInMand(unsigned int i, std::vector <int> &coloursIndicies);
     void getColour(unsigned int vertex, std::vector <int> &coloursIndicies);
-    void collectOneRing(std::vector<std::vector<unsigned int>> &oneRing);
-    void collectTriangleOneRing(std::vector<std::vector<unsigned int>> &oneTriangleRing);
-
-    void planeIntersection(unsigned int index, std::vector <unsigned int> &intersectionTrianglesPlane);
-    void getIntersectionForPlane(unsigned int index, std::vector <unsigned int> &intersectionTrianglesPlane);
-
-    void floodNeighbour(unsigned int index, int id, std::vector<int> &planeNeighbours);     // flood the neighbours of the vertex index with the value id
-    void mergeFlood(const std::vector<int> &planeNeighbours);      // to be called after flooding; merges the regions between the planes
-
-    void createSmoothedTriangles(std::vector <std::vector <unsigned int>> &intersectionTriangles, const std::vector<int> &planeNeighbours);
-    void createSmoothedMandible(std::vector <std::vector <unsigned int>> &intersectionTriangles, const std::vector<int> &planeNeighbours);
-    void createSmoothedFibula(std::vector <std::vector <unsigned int>> &intersectionTriangles, const std::vector<int> &planeNeighbours);
-    void getSegmentsToKeep(const std::vector<int> &planeNeighbours);   // Only for the fibula mesh (gets the segments between 2 planes that we want to keep)
-
-    void cutMesh(std::vector <std::vector <unsigned int>> &intersectionTriangles, const std::vector<int> &planeNeighbours);
-    void cutMandible(bool* truthTriangles, const std::vector<int> &planeNeighbours);
-    void cutFibula(bool* truthTriangles, std::vector <std::vector <unsigned int>> &intersectionTriangles, const std::vector<int> &planeNeighbours);
-    void saveTrianglesToKeep(bool* truthTriangles, unsigned int i);
-    void fillColours(std::vector <int> &coloursIndicies, const unsigned long long nbColours);
-
-    Vec getPolylineProjectedVertex(unsigned int p1, unsigned int p2, unsigned int vertexIndex);
 
     Vec3Df& getVertex(unsigned int i){ return vertices[i]; }
 
-    std::vector <Vec3Df> vertices;      // starting verticies
-    std::vector <Triangle> triangles;       // starting triangles
     std::vector <Plane*> planes;
 
-    std::vector<std::vector<unsigned int>> oneRing;
-    std::vector<std::vector<unsigned int>> oneTriangleRing;
-    std::vector<int> flooding;
+    // Cutting stages
+    TaskGraph cutGraph;
+    bool isDeferred = false;
+    bool isUpdatePending = false;
+    bool isStagesActive = false;        // whether the stages of the current run have anything to do
+    bool isCacheHit = false;        // the cut of the current run came from the cache, only the transfer is left
+    StageTimings timings;
+    unsigned int nbDroppedUpdates = 0;
+    void timeStage(const std::string &stage, const std::function<void()> &f);
 
     bool isCut = false;
-    std::vector<unsigned int> trianglesCut;     // The list of triangles after the cutting (a list of triangle indicies)
-    std::vector<unsigned int> trianglesExtracted;       // The list of triangles taken out (the complement of trianglesCut)
-    std::vector<int> segmentsConserved; // filled with flooding values to keep
-
-    std::vector<Vec3Df> smoothedVerticies;      // New verticies which line up with the cutting plane
-    std::vector<Vec3Df> verticesNormals;
 
     // The fibula in the manible
     std::vector<Vec3Df> fibInMandVerticies;
@@ -116,7 +94,6 @@ protected:
     std::vector<Vec3Df> fibInMandNormals;
     int fibInMandNbColours;
 
-    Side cuttingSide = Side::INTERIOR;
     bool isTransfer = true;
 
     int normalDirection;
@@ -14,25 +14,31 @@ HEADERS  = \
     controlpoint.h \
     curvepoint.h \
     curve.h \
+    interactionrecorder.h \
     mainwindow.h \
     mesh.h \
-    meshreader.h \
     plane.h \
+    planningpipeline.h \
+    stagetimings.h \
     standardcamera.h \
+    tracereplayer.h \
     viewer.h \
-    Triangle.h \
-    Vec3D.h \
     viewerfibula.h
 SOURCES  = main.cpp \
     camerapathplayer.cpp \
     controlpoint.cpp \
     curvepoint.cpp \
     curve.cpp \
+    interactionrecorder.cpp \
     mainwindow.cpp \
     mesh.cpp \
     plane.cpp \
+    planningpipeline.cpp \
+    stagetimings.cpp \
     standardcamera.cpp \
+    tracereplayer.cpp \
     viewer.cpp \
     viewerfibula.cpp
 
+include( ../core/core.pri )
 include( ../baseInclude.pri )
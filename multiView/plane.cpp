@@ -102,48 +102,24 @@ void Plane::setFrameFromBasis(Vec x, Vec y, Vec z){
 * This is the only thing that the plane deals with
 */
 bool Plane::isIntersection(Vec v0, Vec v1, Vec v2){
-
-    // Put it all into local coordinates
-    const Vec &tr0 = cp.getFrame().localCoordinatesOf(v0);
-    const Vec &tr1 = cp.getFrame().localCoordinatesOf(v1);
-    const Vec &tr2 = cp.getFrame().localCoordinatesOf(v2);
-
-    Vec tr[3] = {tr0, tr1, tr2};
-
-    if( (tr0.z < 0 && tr1.z < 0 && tr2.z < 0) || (tr0.z > 0 && tr1.z > 0 && tr2.z > 0) ) return false;  // if they all have the same sign
-    else{
-        for(int i=0; i<3; i++){
-            Vec l = tr[(i+1)%3] - tr[i];
-
-            if(l*normal == 0.0){
-                if( tr[i]*normal == 0.0 ){
-                    if( (abs(tr[i].x) < size && abs(tr[i].y) < size) || ( abs(tr[(i+1)%3].x) < size && abs(tr[(i+1)%3].y) < size)) return true;  // the plan contains the line
-                }
-                else continue;  // the line is parallel
-            }
-
-            double d = normal*(-tr[i]) / (normal*l);
-
-            if(abs(d) > 1.0) continue;
-
-            Vec intersection = d*l + tr[i];
-            if(abs(intersection.x) < size && abs(intersection.y) < size) return true;
-        }
-    }
-
-    return false;   // if we haven't found a line that meets the criteria
+    return getCutPlane().isIntersection(Vec3Dd(v0.x, v0.y, v0.z), Vec3Dd(v1.x, v1.y, v1.z), Vec3Dd(v2.x, v2.y, v2.z));
 }
 
 double Plane::getSign(Vec v){
-    const Vec &tr0 = cp.getFrame().localCoordinatesOf(v);
-    return tr0.z/(abs(tr0.z));
+    return getCutPlane().getSign(Vec3Dd(v.x, v.y, v.z));
 }
 
 Vec Plane::getProjection(Vec p){
-    const Vec &localP = cp.getFrame().localCoordinatesOf(p);       // convert into local coordinates
-    double alpha = (localP * normal);
-    Vec newP = localP - normal *alpha;
-    return cp.getFrame().localInverseCoordinatesOf(newP);   // convert back into original coordinate system
+    const Vec3Dd &newP = getCutPlane().getProjection(Vec3Dd(p.x, p.y, p.z));
+    return Vec(newP[0], newP[1], newP[2]);
+}
+
+// The frame is taken relative to the reference frame, like localCoordinatesOf
+CutPlane Plane::getCutPlane(){
+    const Frame &f = cp.getFrame();
+    const Vec &t = f.translation();
+    const Quaternion &q = f.rotation();
+    return CutPlane(AffineFrame::fromQuaternion(Vec3Dd(t.x, t.y, t.z), q[0], q[1], q[2], q[3]), size);
 }
 
 Vec Plane::getLocalProjection(Vec localP){
@@ -5,6 +5,7 @@
 #include <QGLViewer/manipulatedFrame.h>
 
 #include "curvepoint.h"
+#include "cutplane.h"
 
 enum Movable {STATIC, DYNAMIC};
 
@@ -20,6 +21,7 @@ public:
     float getAlpha(){ return alpha; }
 
     void setSize(double s){ size = s; }
+    double getSize(){ return size; }
     void setPosition(Vec pos);
     void setOrientation(Quaternion q){ cp.getFrame().setOrientation(q); }
     Quaternion fromRotatedBasis(Vec x, Vec y, Vec z);
@@ -42,6 +44,7 @@ public:
     Vec getNormal(){ return normal; }
     //const Frame& getFrame(){ return *cp->getFrame(); }
     Vec getProjection(Vec p);
+    CutPlane getCutPlane();     // a copy of the plane for the mesh geometry
     Vec getLocalProjection(Vec p);      // for vectors already in local coordinates
     Vec& getPosition(){ return cp.getPoint(); }
     CurvePoint& getCurvePoint(){ return cp; }
@@ -0,0 +1,43 @@
+#include "planningpipeline.h"
+#include "trace.h"
+
+PlanningPipeline::PlanningPipeline(Viewer *mandible, ViewerFibula *fibula)
+{
+    this->mandible = mandible;
+    this->fibula = fibula;
+}
+
+void PlanningPipeline::prepare(){
+    mandible->mesh.setDeferred(true);
+    fibula->mesh.setDeferred(true);
+}
+
+void PlanningPipeline::run(){
+    MEDMAX_TRACE("PlanningPipeline::run");
+    graph.clear();
+
+    unsigned int planes = graph.addTask("fibula.planes", [this](){ fibula->handleCut(); }, TaskGraph::MAIN);
+
+    unsigned int mandibleFirst, mandibleLast;
+    mandible->mesh.addCutTasks(graph, "mandible.", mandibleFirst, mandibleLast);
+
+    unsigned int fibulaFirst, fibulaLast;
+    fibula->mesh.addCutTasks(graph, "fibula.", fibulaFirst, fibulaLast);
+    graph.addDependency(planes, fibulaFirst);
+
+    // Sending the segments fills the mandible's copy of the fibula, so wait for both sides
+    unsigned int transfer = graph.addTask("fibula.transfer", [this](){ fibula->mesh.publishCut(); }, TaskGraph::MAIN);
+    graph.addDependency(mandibleLast, transfer);
+    graph.addDependency(fibulaLast, transfer);
+
+    unsigned int redraw = graph.addTask("redraw", [this](){
+        mandible->update();
+        fibula->update();
+    }, TaskGraph::MAIN);
+    graph.addDependency(transfer, redraw);
+
+    graph.run(ThreadPool::global());
+
+    mandible->mesh.setDeferred(false);
+    fibula->mesh.setDeferred(false);
+}
@@ -0,0 +1,34 @@
+#ifndef PLANNINGPIPELINE_H
+#define PLANNINGPIPELINE_H
+
+#include "viewerfibula.h"
+#include "taskgraph.h"
+
+/*
+ * The mandible -> fibula -> mandible cut as one task graph :
+ *
+ *  fibula.planes -> fibula.intersect -> ... -> fibula.smooth ---\
+ *                                                                 > fibula.transfer -> redraw
+ *  mandible.intersect -> ... -> mandible.smooth -----------------/
+ *
+ * While the mandible is sending its planes the mesh updates are only recorded, so each mesh is cut once
+*/
+class PlanningPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    PlanningPipeline(Viewer *mandible, ViewerFibula *fibula);
+    TaskGraph& getLastRun(){ return graph; }
+
+public Q_SLOTS:
+    void prepare();     // the mandible is about to send its planes
+    void run();         // the planes have been sent, cut both meshes
+
+private:
+    Viewer *mandible;
+    ViewerFibula *fibula;
+    TaskGraph graph;
+};
+
+#endif // PLANNINGPIPELINE_H
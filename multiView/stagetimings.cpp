@@ -0,0 +1,30 @@
+#include "stagetimings.h"
+
+void StageTimings::add(const std::string &stage, double ms, const PerfSample &counters){
+    std::lock_guard<std::mutex> lock(mutex);
+    Samples &s = samples[stage];
+    s.last = ms;
+    s.counters = counters;
+    s.sum += ms;
+    s.recent.push_back(ms);
+    if(s.recent.size() > nbAveraged){
+        s.sum -= s.recent.front();
+        s.recent.pop_front();
+    }
+}
+
+bool StageTimings::get(const std::string &stage, double &last, double &average) const{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = samples.find(stage);
+    if(it == samples.end()) return false;
+
+    last = it->second.last;
+    average = it->second.sum / static_cast<double>(it->second.recent.size());
+    return true;
+}
+
+PerfSample StageTimings::getCounters(const std::string &stage) const{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = samples.find(stage);
+    return it != samples.end() ? it->second.counters : PerfSample();
+}
@@ -0,0 +1,32 @@
+#ifndef STAGETIMINGS_H
+#define STAGETIMINGS_H
+
+#include "perfcounters.h"
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+// The last and the rolling average times (ms) of named stages, with the hardware counts of their last run. The stages can be timed from any thread
+class StageTimings
+{
+public:
+    static const unsigned int nbAveraged = 30;
+
+    void add(const std::string &stage, double ms, const PerfSample &counters = PerfSample());
+    bool get(const std::string &stage, double &last, double &average) const;       // false if the stage has never run
+    PerfSample getCounters(const std::string &stage) const;     // not valid unless the counters were on for the last run
+
+private:
+    struct Samples{
+        double last = 0;
+        PerfSample counters;
+        double sum = 0;
+        std::deque<double> recent;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, Samples> samples;
+};
+
+#endif // STAGETIMINGS_H
@@ -0,0 +1,90 @@
+#include "tracereplayer.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// Nearest rank
+static double percentile(const std::vector<double> &sorted, double p){
+    if(sorted.size()==0) return 0;
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    if(rank == 0) rank = 1;
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+void TraceReplayer::run(){
+    samples.clear();
+
+    // Every run of the graphs during an event counts towards it
+    for(unsigned int g=0; g<graphs.size(); g++){
+        const std::string name = graphs[g].first;
+        graphs[g].second->setRunListener([this, name](const TaskGraph &graph){
+            for(unsigned int i=0; i<graph.getNbTasks(); i++) addSample(name + "." + graph.getName(i), graph.getDuration(i));
+            addSample(name + ".total", graph.getTotalDuration());
+        });
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    auto now = [&clock](){ return static_cast<double>(clock.nsecsElapsed()) / 1e6; };
+
+    for(unsigned int i=0; i<events.size(); i++){
+        const TraceEvent &e = events[i];
+        const double scheduled = e.time / speed;
+        while(now() < scheduled){
+            QCoreApplication::processEvents();
+            if(scheduled - now() > 2) QThread::msleep(1);
+        }
+
+        const double t0 = now();
+        dispatch(e);
+        const double t1 = now();
+        QCoreApplication::processEvents();
+        for(unsigned int v=0; v<views.size(); v++) views[v]->repaint();
+        const double t2 = now();
+
+        addSample("dispatch", t1 - t0);
+        addSample("paint", t2 - t1);
+        addSample("latency", t2 - scheduled);
+        addSample("latency." + e.name.toStdString(), t2 - scheduled);
+    }
+
+    for(unsigned int g=0; g<graphs.size(); g++) graphs[g].second->setRunListener(nullptr);
+}
+
+void TraceReplayer::printReport(std::ostream &out) const{
+    out << events.size() << " events replayed at x" << speed << std::endl;
+    out << std::left << std::setw(28) << "stage" << std::right << std::setw(8) << "count"
+        << std::setw(12) << "p50 (ms)" << std::setw(12) << "p95 (ms)" << std::setw(12) << "p99 (ms)" << std::setw(12) << "max (ms)" << std::endl;
+
+    out << std::fixed << std::setprecision(3);
+    for(auto it = samples.begin(); it != samples.end(); ++it){
+        std::vector<double> sorted = it->second;
+        std::sort(sorted.begin(), sorted.end());
+        out << std::left << std::setw(28) << it->first << std::right << std::setw(8) << sorted.size()
+            << std::setw(12) << percentile(sorted, 0.5) << std::setw(12) << percentile(sorted, 0.95)
+            << std::setw(12) << percentile(sorted, 0.99) << std::setw(12) << sorted.back() << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+bool TraceReplayer::saveReport(const QString &fileName) const{
+    std::ofstream file(fileName.toStdString());
+    if(!file.is_open()){
+        std::cout << fileName.toStdString() << " cannot be opened" << std::endl;
+        return false;
+    }
+
+    file << "stage,count,p50 (ms),p95 (ms),p99 (ms),max (ms)" << std::endl;
+    for(auto it = samples.begin(); it != samples.end(); ++it){
+        std::vector<double> sorted = it->second;
+        std::sort(sorted.begin(), sorted.end());
+        file << it->first << "," << sorted.size() << "," << percentile(sorted, 0.5) << "," << percentile(sorted, 0.95) << ","
+             << percentile(sorted, 0.99) << "," << sorted.back() << std::endl;
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef TRACEREPLAYER_H
+#define TRACEREPLAYER_H
+
+#include "interactionrecorder.h"
+#include "taskgraph.h"
+#include <QWidget>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+
+/*
+ * Plays an interaction trace back at the speed it was recorded and measures, for every event, the time from when it
+ * should have happened to when both viewers have redrawn (so slow events delay the next ones, as they would for the user).
+ * The stages of the task graphs which run meanwhile are timed too. The report gives the p50/p95/p99 of each.
+*/
+class TraceReplayer
+{
+public:
+    typedef std::function<void(const TraceEvent&)> Dispatcher;
+
+    TraceReplayer(const std::vector<TraceEvent> &events, Dispatcher dispatch, double speed = 1.0) : events(events), dispatch(dispatch), speed(speed){}
+
+    void addGraph(const std::string &name, TaskGraph &graph){ graphs.push_back(std::make_pair(name, &graph)); }
+    void addView(QWidget *view){ views.push_back(view); }
+
+    void run();     // returns once every event has been played
+
+    void printReport(std::ostream &out) const;
+    bool saveReport(const QString &fileName) const;     // csv
+
+private:
+    void addSample(const std::string &stage, double ms){ samples[stage].push_back(ms); }
+
+    std::vector<TraceEvent> events;
+    Dispatcher dispatch;
+    double speed;
+
+    std::vector<std::pair<std::string, TaskGraph*>> graphs;
+    std::vector<QWidget*> views;
+
+    std::map<std::string, std::vector<double>> samples;     // ms, for each stage
+};
+
+#endif // TRACEREPLAYER_H
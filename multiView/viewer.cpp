@@ -2,6 +2,11 @@
 #include "Triangle.h"
 #include "Vec3D.h"
 #include <QGLViewer/manipulatedFrame.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "planoptimizer.h"
+#include "trace.h"
 
 Viewer::Viewer(QWidget *parent, StandardCamera *cam, int sliderMax) : QGLViewer(parent) {
     Camera *c = camera();       // switch the cameras
@@ -18,6 +23,15 @@ Viewer::Viewer(QWidget *parent, StandardCamera *cam, int sliderMax) : QGLViewer(
 }
 
 void Viewer::draw() {
+    MEDMAX_TRACE("Viewer::draw");
+    const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    const PerfSample counters = PerfCounters::measure([this](){ drawScene(); });
+    mesh.getTimings().add("render", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(), counters);
+
+    if(isPerfHud) drawPerfHud();
+}
+
+void Viewer::drawScene(){
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     glPushMatrix();
@@ -53,6 +67,92 @@ void Viewer::draw() {
     glPopMatrix();
 }
 
+void Viewer::reportMemory(MemoryReport &report){
+    MemoryReport meshReport;
+    mesh.reportMemory(meshReport);
+    report.add("mesh.", meshReport);
+
+    if(isCurve){
+        MemoryReport curveReport;
+        curve->reportMemory(curveReport);
+        report.add("curve.", curveReport);
+    }
+    report.add("ghostPlanes", ghostPlanes);
+    report.add("ghostLocation", ghostLocation);
+    report.add("control", control);
+}
+
+void Viewer::togglePerfHud(){
+    isPerfHud = !isPerfHud;
+    PerfCounters::setEnabled(isPerfHud);        // only count while someone is looking
+    update();
+}
+
+void Viewer::setFrameBudget(double ms){
+    frameBudget = ms;
+    update();
+}
+
+// The last and average (over the last updates) times of the cutting stages on this side and of the last frames,
+// with the IPC and cache / branch misses per 1000 instructions of the last run when the counters can be read
+void Viewer::drawPerfHud(){
+    const char *stages[] = {"cache", "intersect", "seed", "flood", "merge", "cut", "smooth", "normals", "transfer", "render"};
+    const unsigned int nbStages = sizeof(stages) / sizeof(stages[0]);
+
+    const GLboolean isLighting = glIsEnabled(GL_LIGHTING);
+    glDisable(GL_LIGHTING);
+
+    QFont font("Monospace", 9);
+    const int lineHeight = 14;
+    int y = lineHeight + 4;
+
+    glColor3f(1., 1., 1.);
+    drawText(10, y, QString("%1 %2 %3 %4 %5 %6   (ms, budget %7)").arg("stage", -10).arg("last", 7).arg("average", 7).arg("IPC", 5).arg("LLC", 6).arg("branch", 6).arg(frameBudget, 0, 'f', 1), font);
+    y += lineHeight;
+
+    double total = 0;
+    for(unsigned int i=0; i<nbStages; i++){
+        double last, average;
+        if(!mesh.getTimings().get(stages[i], last, average)) continue;
+        total += last;
+
+        if(last > frameBudget || average > frameBudget) glColor3f(1., 0.2, 0.2);
+        else glColor3f(1., 1., 1.);
+        QString line = QString("%1 %2 %3").arg(stages[i], -10).arg(last, 7, 'f', 2).arg(average, 7, 'f', 2);
+        const PerfSample counters = mesh.getTimings().getCounters(stages[i]);
+        if(counters.isValid) line += QString(" %1 %2 %3").arg(counters.getIPC(), 5, 'f', 2).arg(counters.getCacheMPKI(), 6, 'f', 2).arg(counters.getBranchMPKI(), 6, 'f', 2);
+        drawText(10, y, line, font);
+        y += lineHeight;
+    }
+
+    if(total > frameBudget) glColor3f(1., 0.2, 0.2);
+    else glColor3f(1., 1., 1.);
+    drawText(10, y, QString("%1 %2").arg("total", -10).arg(total, 7, 'f', 2), font);
+    y += lineHeight;
+
+    glColor3f(1., 1., 1.);
+    drawText(10, y, QString("triangles cut %1, extracted %2").arg(mesh.getTrianglesCut().size()).arg(mesh.getTrianglesExtracted().size()), font);
+    y += lineHeight;
+    drawText(10, y, QString("dropped updates %1").arg(mesh.getNbDroppedUpdates()), font);
+    y += lineHeight;
+    if(planNbStarts != 0){
+        drawText(10, y, QString("plan optimised over %1 starts : deviation %2 -> %3").arg(planNbStarts).arg(planInitialCost, 0, 'f', 2).arg(planLastCost, 0, 'f', 2), font);
+        y += lineHeight;
+    }
+    const CutCache &cache = mesh.getCutCache();
+    drawText(10, y, QString("cut cache %1 hits, %2 misses, %3 cuts (%4 of %5 MB)").arg(cache.getNbHits()).arg(cache.getNbMisses()).arg(cache.getNbEntries())
+             .arg(static_cast<double>(cache.getBytes()) / (1024.*1024.), 0, 'f', 1).arg(static_cast<double>(cache.getMaxBytes()) / (1024.*1024.), 0, 'f', 1), font);
+    y += lineHeight;
+
+    MemoryReport memory;
+    reportMemory(memory);
+    QString memoryLine = QString("buffers %1 MB").arg(static_cast<double>(memory.getAllocatedBytes()) / (1024.*1024.), 0, 'f', 1);
+    if(MemoryTracker::isEnabled()) memoryLine += QString(", process %1 MB (peak %2 MB)").arg(static_cast<double>(MemoryTracker::getCurrentBytes()) / (1024.*1024.), 0, 'f', 1).arg(static_cast<double>(MemoryTracker::getPeakBytes()) / (1024.*1024.), 0, 'f', 1);
+    drawText(10, y, memoryLine, font);
+
+    if(isLighting) glEnable(GL_LIGHTING);
+}
+
 void Viewer::toggleIsDrawPlane(){
     leftPlane->toggleIsVisible();
     rightPlane->toggleIsVisible();
@@ -158,6 +258,7 @@ void Viewer::initSignals(){
 }
 
 void Viewer::recieveFromFibulaMesh(const std::vector<int> &planes, std::vector<Vec> verticies, const std::vector<std::vector<int>> &triangles, const std::vector<int> &colours, std::vector<Vec> normals, const int nbColours){
+    MEDMAX_TRACE("Viewer::recieveFromFibulaMesh");
     /*
      * 0 : left plane
      * 1 : right plane
@@ -190,37 +291,6 @@ QString Viewer::helpString() const {
   return text;
 }
 
-void swap(int& a, int& b){
-    int temp = a;
-    a = b;
-    b = temp;
-}
-
-int Viewer::partition(int sorted[], int start, int end){
-    int p = sorted[end];
-    int index = start - 1;
-
-    for(int i=start; i<end; i++){
-        double tangentAngleA = angle(curve->tangent(sorted[i]-1), curve->tangent(sorted[i]));
-        double tangentAngleP = angle(curve->tangent(p-1), curve->tangent(p));
-
-        if(tangentAngleA >= tangentAngleP){
-            index++;
-            swap(sorted[index], sorted[i]);
-        }
-    }
-    swap(sorted[index+1], sorted[end]);
-    return index+1;
-}
-
-void Viewer::quicksort(int sorted[], int start, int end){
-    if(start < end){
-        int p = partition(sorted, start, end);
-        quicksort(sorted, start, p-1);
-        quicksort(sorted, p+1, end);
-    }
-}
-
 void Viewer::drawMesh(){
     if(isDrawMesh) isDrawMesh = false;      // change states
     else isDrawMesh = true;
@@ -239,60 +309,27 @@ void Viewer::initGhostPlanes(){
     for(unsigned int i=0; i<ghostPlanes.size(); i++) delete ghostPlanes[i];     // get rid of any previous ghost planes
     ghostPlanes.clear();
 
-    int finalNb = nbGhostPlanes;        // the number we can actually fit in
-    int maxIndicies[nbGhostPlanes];
+    const unsigned int startI = curve->indexForLength(curveIndexL, constraint);
+    const unsigned int endI = curve->indexForLength(curveIndexR, -constraint);
 
-    const int startI = static_cast<const int>(curve->indexForLength(curveIndexL, constraint));
-    const int endI = static_cast<const int>(curve->indexForLength(curveIndexR, -constraint));
-    const int searchArea = endI - startI;       // the space that's left between the left and right planes after the constraint is taken into account
+    if(endI > startI){         // if there's enough space for a plane
+        std::vector<unsigned int> chosen = PlanOptimizer::greedyPlan(curve->getGeometry(), startI, endI, static_cast<unsigned int>(nbGhostPlanes), constraint);
 
-
-    if(searchArea > 0){         // if there's enough space for a plane
-        int sorted[searchArea];
-
-        for(int i=0; i<searchArea; i++) sorted[i] = startI+i;       // the possible indexes for the plane
-
-        quicksort(sorted, 0, searchArea-1);      // Sort the indicies according to their tangent angles
-
-        maxIndicies[0] = sorted[0];
-        int sortedIndex = 1;
-
-        for(int i=1; i<nbGhostPlanes; i++){
-            // the constraint (don't take it if it's too close to another existing plane)
-            bool tooClose;
-            do{
-                tooClose = false;
-                for(int j=i-1; j>=0; j--){
-                    if(sortedIndex < searchArea && curve->discreteLength(static_cast<unsigned int>(maxIndicies[static_cast<unsigned int>(j)]),static_cast<unsigned int>(sorted[static_cast<unsigned int>(sortedIndex)]))<constraint){
-                        tooClose = true;
-                        break;
-                    }
-                }
-                if(tooClose) sortedIndex++;
-            }while(tooClose);
-
-            if(sortedIndex >= searchArea){      // if we leave the search area, stop
-                finalNb = i;
-                break;
-            }
-            maxIndicies[i] = sorted[sortedIndex];
-            sortedIndex++;  // move with i
-        }
-
-        // sort the planes
-        for(int i=0; i<finalNb; i++){
-            for(int j=i+1; j<finalNb; j++){
-                if(maxIndicies[i] > maxIndicies[j]) swap(maxIndicies[i], maxIndicies[j]);
-            }
+        if(isOptimisePlan){
+            PlanOptimizer optimizer(curve->getGeometry(), constraint);
+            chosen = optimizer.optimise(curveIndexL, curveIndexR, chosen, ThreadPool::global());
+            planNbStarts = optimizer.getNbStarts();
+            planInitialCost = optimizer.getInitialCost();
+            planLastCost = optimizer.getLastCost();
         }
+        const int finalNb = static_cast<int>(chosen.size());       // the number we can actually fit in
 
-        ghostLocation.clear();
-        for(int i=0; i<finalNb; i++) ghostLocation.push_back(maxIndicies[i]);       // get the location for each ghost plane
+        ghostLocation = chosen;       // get the location for each ghost plane
 
         // the number of ghost planes we can currently fit
         currentNbGhostPlanes = finalNb;
 
-        addGhostPlanes(finalNb);
+        addGhostPlanes(static_cast<unsigned int>(finalNb));
 
         for(unsigned int i=0; i<ghostPlanes.size(); i++) connect(&(ghostPlanes[i]->getCurvePoint()), &CurvePoint::curvePointTranslated, this, &Viewer::ghostPlaneMoved);        // connnect the ghost planes
 
@@ -301,11 +338,11 @@ void Viewer::initGhostPlanes(){
         const std::vector<Vec> &axes = getReferenceAxes();
         double distance;        // the distance we moved
 
-        if(finalNb > 0) distance = curve->discreteLength(curveIndexL, static_cast<unsigned int>(ghostLocation[0]));
+        if(finalNb > 0) distance = curve->discreteLength(curveIndexL, ghostLocation[0]);
         else distance = curve->discreteLength(curveIndexL, curveIndexR);
         Q_EMIT leftPosChanged(distance, poly, axes);
 
-        if(finalNb > 0) distance = curve->discreteLength(curveIndexR, ghostLocation[finalNb-1]);
+        if(finalNb > 0) distance = curve->discreteLength(curveIndexR, ghostLocation[static_cast<unsigned int>(finalNb-1)]);
         else distance = curve->discreteLength(curveIndexL, curveIndexR);
         Q_EMIT rightPosChanged(distance, poly, axes);
     }
@@ -314,8 +351,12 @@ void Viewer::initGhostPlanes(){
 void Viewer::cutMesh(){
     bool isNumberRecieved;
     int nbPieces = QInputDialog::getInt(this, "Cut mesh", "Number of pieces", 0, 1, 10, 1, &isNumberRecieved, Qt::WindowFlags());
-    if(isNumberRecieved) nbGhostPlanes = nbPieces-1;
-    else return;
+    if(isNumberRecieved) cutIntoPieces(nbPieces);
+}
+
+void Viewer::cutIntoPieces(int nbPieces){
+    Q_EMIT cutRequested(nbPieces);
+    nbGhostPlanes = nbPieces-1;
 
     isGhostPlanes = true;
 
@@ -323,11 +364,11 @@ void Viewer::cutMesh(){
 
     if(nbGhostPlanes==0) Q_EMIT noGhostPlanesToSend(updatePolyline(), getReferenceAxes(), curve->discreteLength(curveIndexL, curveIndexR));
 
-    Q_EMIT okToCut();
-
     mesh.setIsCut(Side::INTERIOR, true, true);      // cut the mandible mesh and initialise the ghost planes
     initGhostPlanes();
 
+    Q_EMIT okToCut();       // the fibula has everything it needs
+
     update();
 }
 
@@ -342,7 +383,7 @@ void Viewer::uncutMesh(){
 // Slide the left plane
 void Viewer::moveLeftPlane(int position){
     double percentage = static_cast<double>(position) / static_cast<double>(sliderMax);
-    unsigned int index = static_cast<unsigned int>(percentage * static_cast<double>(nbU) );
+    unsigned int index = curve->indexAtLength(percentage * curve->getTotalLength());     // the samples aren't evenly spaced
 
     if(curve->indexForLength(curveIndexR, -constraint) > index){  // Only move if we're going backwards or we haven't met the other plane
         curveIndexL = index;
@@ -358,7 +399,7 @@ void Viewer::moveLeftPlane(int position){
 
 void Viewer::moveRightPlane(int position){
     double percentage = static_cast<double>(position) / static_cast<double>(sliderMax);
-    unsigned int index = nbU - 1 - static_cast<unsigned int>(percentage * static_cast<double>(nbU) );
+    unsigned int index = curve->indexAtLength((1.0 - percentage) * curve->getTotalLength());
 
     if( index > curve->indexForLength(curveIndexL, constraint)){        // its within the correct boundaries
         curveIndexR = index;
@@ -444,20 +485,24 @@ void Viewer::handlePlaneMoveEnd(){
     // Recut
     Q_EMIT preparingToCut();
     if(!isSpaceForGhosts() || nbGhostPlanes==0) Q_EMIT noGhostPlanesToSend(updatePolyline(), getReferenceAxes(), curve->discreteLength(curveIndexL, curveIndexR));
-    Q_EMIT okToCut();
 
     mesh.setIsCut(Side::INTERIOR, true, true);
     isGhostPlanes = true;
     initGhostPlanes();
+
+    Q_EMIT okToCut();
 }
 
 void Viewer::openOFF(QString filename) {
     std::vector<Vec3Df> &vertices = mesh.getVertices();
     std::vector<Triangle> &triangles = mesh.getTriangles();
 
+    mesh.clear();       // nothing of the last mesh is kept, its load order included
     FileIO::openOFF(filename.toStdString(), vertices, triangles);
 
+    mesh.reorderForLocality();
     mesh.init();
+    indexCurve();
 
     // Set the camera
     Vec3Df center;
@@ -488,12 +533,17 @@ void Viewer::initCurve(){
 
 void Viewer::constructCurve(){
     curve = new Curve(control.size(), control);
-    nbU = 100;
-    curve->generateCatmull(nbU);
+    curve->generateAdaptiveCatmull(0.01, 1.0, nbU);     // within 10 microns of the curve, and at least every mm to place the planes
     isCurve = true;
+    indexCurve();
     initPlanes(Movable::DYNAMIC);
 }
 
+void Viewer::indexCurve(){
+    if(!isCurve || mesh.getTriangles().size()==0) return;
+    mesh.buildSlabIndex(curve->getGeometry(), 40.0, ThreadPool::global());     // the size of the planes
+}
+
 void Viewer::initPlanes(Movable status){
     curveIndexR = nbU - 1;
     curveIndexL = 0;
@@ -515,7 +565,7 @@ void Viewer::initPlanes(Movable status){
 
 void Viewer::repositionPlane(Plane *p, unsigned int index){
     p->setPosition(curve->getPoint(index));
-    matchPlaneToFrenet(p, index);
+    matchPlaneToFrame(p, index);
 }
 
 void Viewer::addGhostPlanes(unsigned int nb){
@@ -540,7 +590,39 @@ void Viewer::addGhostPlanes(unsigned int nb){
     Q_EMIT ghostPlanesAdded(nb, distances, poly, axes);
 }
 
+void Viewer::manipulatePlane(unsigned int index, const Vec &position){
+    if(!isCurve) return;
+
+    Plane *p = nullptr;
+    if(index==0) p = leftPlane;
+    else if(index==1) p = rightPlane;
+    else if(index-2 < ghostPlanes.size()) p = ghostPlanes[index-2];
+    if(!p) return;
+
+    CurvePoint &cp = p->getCurvePoint();
+    cp.getFrame().setPosition(position);
+    cp.cntrlMoved();        // the same signals as a mouse drag
+}
+
 void Viewer::ghostPlaneMoved(){
+    MEDMAX_TRACE("Viewer::ghostPlaneMoved");
+    // Say which plane was dragged and where to (for the interaction traces)
+    const QObject *moved = sender();
+    Plane *movedPlane = nullptr;
+    unsigned int movedIndex = 0;
+    if(moved == &(leftPlane->getCurvePoint())) movedPlane = leftPlane;
+    else if(moved == &(rightPlane->getCurvePoint())){
+        movedPlane = rightPlane;
+        movedIndex = 1;
+    }
+    for(unsigned int i=0; i<ghostPlanes.size(); i++){
+        if(moved == &(ghostPlanes[i]->getCurvePoint())){
+            movedPlane = ghostPlanes[i];
+            movedIndex = i+2;
+        }
+    }
+    if(movedPlane) Q_EMIT planeManipulated(movedIndex, movedPlane->getPosition());
+
     unsigned int nb = static_cast<unsigned int>(ghostPlanes.size());
     double distances[nb+1];     // +1 for the last plane
 
@@ -565,11 +647,21 @@ void Viewer::updateCamera(const Vec3Df & center, float radius){
     camera()->showEntireScene();
 }
 
-void Viewer::updatePlanes(){
-    repositionPlane(leftPlane, curveIndexL);
-    repositionPlane(rightPlane, curveIndexR);
+// Only the planes on the samples [start, end) of the curve have moved
+void Viewer::updatePlanes(unsigned int start, unsigned int end){
+    bool isMoved = false;
+    mesh.updateSlabIndex(curve->getGeometry(), start, end, ThreadPool::global());
+
+    if(curveIndexL >= start && curveIndexL < end){
+        repositionPlane(leftPlane, curveIndexL);
+        isMoved = true;
+    }
+    if(curveIndexR >= start && curveIndexR < end){
+        repositionPlane(rightPlane, curveIndexR);
+        isMoved = true;
+    }
 
-    mesh.updatePlaneIntersections();
+    if(isMoved) mesh.updatePlaneIntersections();
 
     update();
 }
@@ -594,10 +686,8 @@ double Viewer::segmentLength(const Vec a, const Vec b){
     return sqrt( pow((b.x - a.x), 2) + pow((b.y - a.y), 2) + pow((b.z - a.z), 2));
 }
 
-void Viewer::matchPlaneToFrenet(Plane *p, unsigned int index){
-    Vec x, y, z;
-    curve->getFrame(index,z,x,y);
-    p->setFrameFromBasis(x,y,z);
+void Viewer::matchPlaneToFrame(Plane *p, unsigned int index){
+    p->setOrientation(curve->getOrientation(index));
 }
 
 Vec Viewer::convertToPlane(Plane *base, Plane *p, Vec axis){
@@ -611,6 +701,7 @@ void Viewer::rotateFrame(Frame &f, Vec axis, double theta){
 }
 
 void Viewer::getAxes(){
+    MEDMAX_TRACE("Viewer::getAxes");
     Q_EMIT sendAxes(getReferenceAxes());
 }
 
@@ -7,6 +7,7 @@
 #include "standardcamera.h"
 #include "plane.h"
 #include "curve.h"
+#include "perfcounters.h"
 using namespace qglviewer;
 
 class Viewer : public QGLViewer
@@ -19,13 +20,22 @@ public :
     void readJSON(const QJsonArray &json);
     Mesh mesh;
 
+    Curve* getCurve(){ return isCurve ? curve : nullptr; }
+    unsigned int getCurveIndexL(){ return curveIndexL; }
+    unsigned int getCurveIndexR(){ return curveIndexR; }
+    double getConstraint(){ return constraint; }
+    void reportMemory(MemoryReport &report);        // the mesh, the curve and the planes
+    bool getIsOptimisePlan(){ return isOptimisePlan; }
+
 public Q_SLOTS:
     void moveLeftPlane(int);
     void moveRightPlane(int);
     void rotateLeftPlane(int);
     void rotateRightPlane(int);
-    void updatePlanes();
+    void updatePlanes(unsigned int start, unsigned int end);
     virtual void cutMesh();
+    void cutIntoPieces(int nbPieces);
+    void manipulatePlane(unsigned int index, const Vec &position);     // as if the plane had been dragged to position (0 left, 1 right, then the ghost planes)
     virtual void uncutMesh();
     void ghostPlaneMoved();
     void drawMesh();
@@ -36,13 +46,16 @@ public Q_SLOTS:
     void getAxes();
     void toggleIsDrawPlane();
     void setAlpha(int);
+    void setOptimisePlan(bool isOptimise){ isOptimisePlan = isOptimise; }      // search for the ghost plane positions which follow the curve best
+    void togglePerfHud();
+    void setFrameBudget(double ms);     // the stages slower than this are shown in red on the HUD
 
 Q_SIGNALS:
     void leftPosChanged(double, std::vector<Vec>, std::vector<Vec>);
     void rightPosChanged(double, std::vector<Vec>, std::vector<Vec>);
     void ghostPlanesAdded(unsigned int, double[], std::vector<Vec>, std::vector<Vec>);
     void ghostPlanesTranslated(unsigned int, double[], std::vector<Vec>, std::vector<Vec>);
-    void okToCut();
+    void okToCut();     // the mandible has sent its planes, both meshes can be cut
 
     // set the slider to the value
     void setLRSliderValue(int);   // Left rotation
@@ -52,16 +65,21 @@ Q_SIGNALS:
     void sendFibulaToMesh(std::vector<Vec>, const std::vector<std::vector<int>>&, const std::vector<int>&, std::vector<Vec>, int);
 
     void noGhostPlanesToSend(std::vector<Vec>, std::vector<Vec>, double);     // tells the fibula not to wait for ghost planes before cutting
-    void preparingToCut();          // tells the fibula to reset its planes
+    void preparingToCut();          // tells the fibula to reset its planes (and the pipeline to hold back the mesh updates)
 
     void ghostPlaneMovementStart();      // tells the fibula to "uncut" the mesh while we move the planes
 
     void sendAxes(std::vector<Vec>);
 
+    void cutRequested(int nbPieces);
+    void planeManipulated(unsigned int index, Vec position);     // a plane has been dragged with the mouse (same numbering as manipulatePlane)
+
 protected:
     void draw();
+    void drawScene();
     std::vector<Vec> updatePolyline();   // returns the new angles between the polyline and the planes
     void drawPolyline();
+    void drawPerfHud();
     void init();
     QString helpString() const;
     void updateCamera(const Vec3Df & center, float radius);
@@ -79,6 +97,7 @@ protected:
     void repositionPlane(Plane* p, unsigned int index);
 
     virtual void constructCurve();
+    void indexCurve();      // the triangles near each sample of the curve, once there's both a mesh and a curve
 
     ManipulatedFrame* viewerFrame;
 
@@ -100,6 +119,13 @@ protected:
     bool isDrawMesh;
 
     const double constraint = 25;
+    bool isOptimisePlan = false;
+    unsigned int planNbStarts = 0;      // the last optimised plan, for the HUD (0 : none yet)
+    double planInitialCost = 0;
+    double planLastCost = 0;
+
+    bool isPerfHud = false;
+    double frameBudget = 1000. / 60.;       // ms
 
     std::vector<Vec> control;
     bool isCurve;
@@ -109,7 +135,7 @@ protected:
 private:
     void initGhostPlanes();
     Quaternion updateOrientation(unsigned int index);
-    void matchPlaneToFrenet(Plane* p, unsigned int index);
+    void matchPlaneToFrame(Plane* p, unsigned int index);
     void handlePlaneMoveStart();
     void handlePlaneMoveEnd();
     void updateMeshPolyline(std::vector<Vec> &polyline);
@@ -118,8 +144,6 @@ private:
 
     std::vector<Vec> getReferenceAxes();        // get all the z axes in terms of their directors
     std::vector<Vec> getPolylinePlaneAngles(std::vector<Vec> &polyline);      // returns the polyline in the coordinates of each plane, one for each side of the plane
-    int partition(int sorted[], int start, int end);
-    void quicksort(int sorted[], int start, int end);
 
     void rotatePlane(Plane* p, int position);
     void movePlane(Plane *p, bool isLeft, unsigned int index);
@@ -1,12 +1,12 @@
 #include "viewerfibula.h"
+#include "fibulaplanning.h"
+#include "trace.h"
 
 ViewerFibula::ViewerFibula(QWidget *parent, StandardCamera *camera, int sliderMax, int fibulaOffset) : Viewer (parent, camera, sliderMax)
 {
-    indexOffset = 0;
-    prevOffset = 0;
+    lengthOffset = 0;
     maxOffset = fibulaOffset;
     isPlanesRecieved = false;
-    isCutSignal = false;
 }
 
 void ViewerFibula::initSignals(){
@@ -148,6 +148,7 @@ void ViewerFibula::swivelPlane(Plane *p, const Vec &fibPoly, const Vec &mandPoly
 
 // Rotate the end plane to match the mandibule
 void ViewerFibula::recieveAxes(std::vector<Vec> axes){
+    MEDMAX_TRACE("ViewerFibula::recieveAxes");
 
     if(ghostPlanes.size()==0){
         leftPlane->setOrientationFromOtherReference(axes, 0, rightPlane);
@@ -169,11 +170,13 @@ void ViewerFibula::recieveAxes(std::vector<Vec> axes){
 
 // Move all planes by the same offset (right plane INCLUDED) - when the slider is dragged
 void ViewerFibula::movePlanes(int position){
-    int offset = static_cast<int>(static_cast<double>(position)/ static_cast<double>(maxOffset) * static_cast<double>(nbU));
+    // The samples aren't evenly spaced, so the slider moves along the length of the curve
+    double offset = static_cast<double>(position)/ static_cast<double>(maxOffset) * curve->getTotalLength();
+    double shift = offset - lengthOffset;
 
     // Check that it this offset doesn't exceed the size of the fibula
-    if(static_cast<int>(curveIndexL) + offset < static_cast<int>(nbU) && static_cast<int>(curveIndexL) + offset > 0 && static_cast<int>(curveIndexR) + offset < static_cast<int>(nbU) && static_cast<int>(curveIndexR) + offset > 0){
-        indexOffset = offset;
+    if(curve->lengthAtIndex(curveIndexL) + shift >= 0 && curve->lengthAtIndex(curveIndexR) + shift < curve->getTotalLength()){
+        lengthOffset = offset;
         findIndexesFromDistances();
         setPlanePositions();
         update();
@@ -195,7 +198,7 @@ void ViewerFibula::addGhostPlanes(unsigned int nb){
     Vec pos(0,0,0);
 
     for(unsigned int i=0; i<static_cast<unsigned int>(nb); i++){
-        ghostPlanes.push_back(new Plane(25.0, Movable::STATIC, pos, leftPlane->getAlpha()));
+        ghostPlanes.push_back(new Plane(FibulaPlanning::ghostPlaneSize, Movable::STATIC, pos, leftPlane->getAlpha()));
 
         // If we're too far along the fibula, take it all back
         /*int overload = static_cast<int>(ghostLocation[i]) + indexOffset - static_cast<int>(curve->getNbU()) + 1;   // The amount by which the actual index passes the end of the curve
@@ -219,9 +222,7 @@ void ViewerFibula::findGhostLocations(unsigned int nb, double distance[]){
 void ViewerFibula::findIndexesFromDistances(){
     ghostLocation.clear();
     unsigned int nb = static_cast<unsigned int>(distances.size()-1);
-    int shift = indexOffset - prevOffset;
-    curveIndexL = static_cast<unsigned int>(static_cast<int>(curveIndexL) + shift);
-    prevOffset = indexOffset;
+    curveIndexL = curve->indexAtLength(lengthOffset);
 
     if(nb!=0){
         unsigned int index = curve->indexForLength(curveIndexL, distances[0]);
@@ -240,16 +241,17 @@ void ViewerFibula::findIndexesFromDistances(){
 
 // Don't wait for ghost planes, go ahead and cut
 void ViewerFibula::noGhostPlanesToRecieve(std::vector<Vec> mandPolyline, std::vector<Vec> axes, double dist){
+    MEDMAX_TRACE("ViewerFibula::noGhostPlanesToRecieve");
     isPlanesRecieved = true;
     isGhostPlanes = true;
     distances.clear();
     distances.push_back(dist);
     repositionPlanes(mandPolyline, axes);
-    handleCut();
 }
 
 // Add ghost planes that correspond to the ghost planes in the jaw
 void ViewerFibula::ghostPlanesRecieved(unsigned int nb, double distance[], std::vector<Vec> mandPolyline, std::vector<Vec> axes){
+    MEDMAX_TRACE("ViewerFibula::ghostPlanesRecieved");
     if(nb==0) return;
 
     findGhostLocations(nb, distance);
@@ -258,11 +260,11 @@ void ViewerFibula::ghostPlanesRecieved(unsigned int nb, double distance[], std::
     repositionPlanes(mandPolyline, axes);
 
     isPlanesRecieved = true;
-    handleCut();
 }
 
 // When we want to move the right plane
 void ViewerFibula::movePlaneDistance(double distance, std::vector<Vec> mandPolyline, std::vector<Vec> axes){
+    MEDMAX_TRACE("ViewerFibula::movePlaneDistance");
     unsigned int newIndex;
 
     if(ghostPlanes.size()==0) newIndex = curve->indexForLength(curveIndexL, distance);
@@ -278,6 +280,7 @@ void ViewerFibula::movePlaneDistance(double distance, std::vector<Vec> mandPolyl
 
 // One of the ghost planes is moved in the jaw
 void ViewerFibula::middlePlaneMoved(unsigned int nb, double distances[], std::vector<Vec> mandPolyline, std::vector<Vec> axes){
+    MEDMAX_TRACE("ViewerFibula::middlePlaneMoved");
     if(nb==0) return;
 
     findGhostLocations(nb, distances);
@@ -309,21 +312,21 @@ void ViewerFibula::initCurve(){
 }
 
 void ViewerFibula::constructCurve(){
-    nbU = 2000;
     curve = new Curve(control.size(), control);
-    curve->generateCatmull(nbU);
+    curve->generateAdaptiveCatmull(0.01, 0.5, nbU);     // within 10 microns of the curve, and at least every half mm to place the planes
     connect(curve, &Curve::curveReinitialised, this, &Viewer::updatePlanes);
     isCurve = true;
+    indexCurve();
     initPlanes(Movable::STATIC);
 }
 
 void ViewerFibula::cutMesh(){
-    isCutSignal = true;
     handleCut();
 }
 
+// Called by the planning pipeline once the mandible has finished sending the planes
 void ViewerFibula::handleCut(){
-    if(isCutSignal && isPlanesRecieved){
+    if(isPlanesRecieved){
         for(unsigned int i=0; i<ghostPlanes.size(); i++){
             mesh.addPlane(ghostPlanes[i]);
         }
@@ -332,7 +335,6 @@ void ViewerFibula::handleCut(){
         else mesh.setIsCut(Side::EXTERIOR, true, false);
 
         isGhostPlanes = true;
-        isCutSignal = false;
         isPlanesRecieved = false;
     }
 }
@@ -407,7 +409,6 @@ void ViewerFibula::approachPlanes(unsigned int pStart){
     Vec p1, p2;
     findClosestPoint(pStart, p1, p2);
     double distZ = p2.z - p1.z;
-    const double security = 15.0;
 
     Vec pB1, pB2;
     pB1 = curve->getPoint(ghostLocation[pStart]);
@@ -416,7 +417,7 @@ void ViewerFibula::approachPlanes(unsigned int pStart){
 
     double distPercentage = distZ/currentDistZ;
     double distShift = euclideanDistance(pB1, pB2) * distPercentage;
-    if(distShift > security) distShift -= security;
+    if(distShift > FibulaPlanning::approachSecurity) distShift -= FibulaPlanning::approachSecurity;
     else distShift = 0;
     distances[pStart+1] -= distShift;
 }
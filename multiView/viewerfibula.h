@@ -12,6 +12,7 @@ public:
     void addGhostPlanes(unsigned int nb);
     void handleCut();
     std::vector<Vec> getPolyline();
+    double getSecurityMargin(){ return securityMargin; }
 
 public Q_SLOTS:
     void movePlanes(int);
@@ -53,11 +54,9 @@ private:
     void approachPlanes(unsigned int pStart);
     double euclideanDistance(Vec &a, Vec &b);
 
-    bool isCutSignal;
-    bool isPlanesRecieved;
+    bool isPlanesRecieved;      // the mandible has sent the planes, the planning pipeline can cut
 
-    int indexOffset;
-    int prevOffset;
+    double lengthOffset;        // how far along the fibula the planes have been slid (mm)
     int maxOffset;
     std::vector<Vec> mandiblePolyline;      // the last mandible polyline we recieved
     std::vector<Vec> mandibleAxes;          // the last mandible axes we recieved